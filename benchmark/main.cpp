@@ -0,0 +1,834 @@
+#include <imperative/graph.hpp>
+#include <imperative/A_star.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/bidirectional_A_star.hpp>
+#include <imperative/landmarks.hpp>
+#include <imperative/contraction_hierarchy.hpp>
+#include <imperative/jump_point_search.hpp>
+#include <imperative/A_star_batch.hpp>
+#include <imperative/HDA_star.hpp>
+#include <imperative/delta_stepping.hpp>
+#include <imperative/D_star_lite.hpp>
+#include <imperative/hierarchical_graph.hpp>
+#include <imperative/ARA_star.hpp>
+#include <imperative/path_cache.hpp>
+#include <imperative/distance_matrix.hpp>
+#include <imperative/mapped_graph.hpp>
+#include <imperative/reorder.hpp>
+#include <imperative/spatial_index.hpp>
+#include <imperative/edge_list.hpp>
+#include <benchmark/synthetic.hpp>
+#include <benchmark/movingai.hpp>
+#include <benchmark/measure.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <tuple>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <numeric>
+#include <random>
+#include <fstream>
+#include <charconv>
+#include <span>
+
+
+// Usage: benchmark [workloads...] [options...]
+//
+// Workloads:
+//   --map <file.map> [--scen <file.scen>]    A MovingAI map. Queries are taken from the scenario file if one is given.
+//   --grid <width> <height> <blocked>        A random 8-connected grid where each cell is blocked with the given probability.
+//   --geometric <nodes> <radius>             A random geometric graph (see bench::make_geometric).
+//
+// Options:
+//   --queries <n>    Number of random queries for workloads without a scenario file. Defaults to 1000.
+//   --seed <n>       Seed for the synthetic graphs and random queries. Defaults to 1.
+//   --compare        Compare the different engines on each workload instead of writing the JSON report.
+//   --trace <file>   With --compare, write a Chrome trace of the searches with search_stats on the first workload to the file.
+//
+// If no workloads are given, a 512 x 512 grid with 20% blocked cells is used.
+// The JSON report is written to stdout.
+
+
+using namespace imp;
+
+
+struct query {
+    node* from;
+    node* to;
+    // Known shortest path length, or NaN if it is unknown.
+    double optimal_length;
+};
+
+
+struct workload {
+    std::string name;
+    graph g;
+    std::vector<query> queries;
+    // Grids use the octile heuristic, everything else uses the euclidean distance.
+    bool is_grid;
+};
+
+
+// Invokes fn with the heuristic for the workload. Octile distances overestimate the edges of non-grid graphs, so they would be inadmissible there.
+decltype(auto) with_heuristic(const workload& w, auto&& fn) {
+    if (w.is_grid) return fn(octile_cost {});
+    else return fn(euclidean_cost {});
+}
+
+
+// Sum of the stored edge costs along the path.
+double path_length(const std::vector<node*>& path) {
+    double result = 0;
+    
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        result += path[i - 1]->costs[path[i - 1]->edge_index(*path[i])];
+    }
+    
+    return result;
+}
+
+
+// Writes g as a DIMACS edge list (see load_edge_list), with the edges either in the order of their source nodes or shuffled.
+// newline is written after every line, except the last one if final_newline is false.
+void write_edge_list(const graph& g, const std::string& path, bool shuffled, std::string_view newline, bool final_newline) {
+    std::vector<std::pair<const node*, std::size_t>> edges;
+    for (const auto& n : g.nodes) for (std::size_t i = 0; i < n->neighbours.size(); ++i) edges.emplace_back(n.get(), i);
+    
+    if (shuffled) std::shuffle(edges.begin(), edges.end(), std::mt19937 { 1 });
+    
+    
+    std::ofstream stream { path, std::ios::binary };
+    if (!stream) throw std::runtime_error { "Failed to create edge list: " + path };
+    
+    std::string buffer;
+    bool first_line = true;
+    
+    auto line = [&](char tag, auto... fields) {
+        if (!first_line) buffer += newline;
+        first_line = false;
+        
+        buffer += tag;
+        
+        ([&] {
+            char text[32];
+            buffer += ' ';
+            buffer.append(text, std::to_chars(text, text + sizeof(text), fields).ptr);
+        }(), ...);
+        
+        if (buffer.size() >= (1 << 20)) {
+            stream.write(buffer.data(), std::streamsize(buffer.size()));
+            buffer.clear();
+        }
+    };
+    
+    
+    buffer += "c generated by the benchmark";
+    buffer += newline;
+    buffer += "p sp " + std::to_string(g.nodes.size()) + " " + std::to_string(edges.size());
+    first_line = false;
+    
+    for (const auto& n : g.nodes) line('v', n->id + 1, n->position.x, n->position.y);
+    for (const auto& [n, i] : edges) line('a', n->id + 1, n->neighbours[i]->id + 1, n->costs[i]);
+    
+    if (final_newline) buffer += newline;
+    
+    stream.write(buffer.data(), std::streamsize(buffer.size()));
+    if (!stream) throw std::runtime_error { "Failed to write edge list: " + path };
+}
+
+
+// True if a and b have the same positions and the same edges, in any order.
+bool same_graph(const csr_graph& a, const csr_graph& b) {
+    if (a.node_count() != b.node_count() || a.edge_count() != b.edge_count()) return false;
+    
+    std::vector<std::pair<csr_graph::id_type, float>> edges_a, edges_b;
+    
+    for (csr_graph::id_type i = 0; i < a.node_count(); ++i) {
+        if (a.position(i).x != b.position(i).x || a.position(i).y != b.position(i).y) return false;
+        
+        edges_a.clear();
+        edges_b.clear();
+        
+        for (std::size_t e = 0; e < a.neighbours(i).size(); ++e) edges_a.emplace_back(a.neighbours(i)[e], a.costs(i)[e]);
+        for (std::size_t e = 0; e < b.neighbours(i).size(); ++e) edges_b.emplace_back(b.neighbours(i)[e], b.costs(i)[e]);
+        
+        std::sort(edges_a.begin(), edges_a.end());
+        std::sort(edges_b.begin(), edges_b.end());
+        
+        if (edges_a != edges_b) return false;
+    }
+    
+    return true;
+}
+
+
+void print_result(std::string_view name, double us_per_query, std::size_t total_length) {
+    std::cout << std::left << std::setw(40) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2) << us_per_query << " us/query"
+              << "    (total path length " << total_length << ")\n";
+}
+
+
+// Runs fn for every query and prints the average time per query.
+// The total path length is printed as well, both to check the variants agree and to stop the searches being optimized out.
+void run(std::string_view name, const auto& queries, auto&& fn) {
+    std::size_t total_length = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    for (const auto& [from, to] : queries) total_length += fn(from, to).size();
+    
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    print_result(name, elapsed.count() / queries.size(), total_length);
+}
+
+
+void compare_engines(workload& w, const std::optional<std::string>& trace_path) {
+    graph& g = w.g;
+    
+    std::vector<std::pair<node*, node*>> queries;
+    for (const auto& q : w.queries) if (q.from && q.to) queries.emplace_back(q.from, q.to);
+    
+    std::cout << w.name << ":\n";
+    
+    
+    search_workspace ws, backward_ws;
+    
+    
+    // Cost policies: virtual dispatch through cost_function& versus inlined concrete types.
+    distance_based_cost distance_cost;
+    cost_function& virtual_cost = distance_cost;
+    
+    run("virtual cost_function&", queries, [&](node* a, node* b) { return A_star(g, a, b, virtual_cost, virtual_cost, ws); });
+    run("distance_based_cost (devirtualized)", queries, [&](node* a, node* b) { return A_star(g, a, b, distance_cost, distance_cost, ws); });
+    run("euclidean_cost policy", queries, [&](node* a, node* b) { return A_star(g, a, b, euclidean_cost {}, euclidean_cost {}, ws); });
+    run("euclidean_cost + stored edge costs", queries, [&](node* a, node* b) { return A_star(g, a, b, euclidean_cost {}, ws); });
+    // Octile distances overestimate the edges of non-grid graphs, so the octile rows are only run on grids.
+    if (w.is_grid) run("octile_cost + stored edge costs", queries, [&](node* a, node* b) { return A_star(g, a, b, octile_cost {}, ws); });
+    
+    
+    // Overhead of collecting search statistics, compared to the stored edge costs row with the same heuristic.
+    // Tracing records an event per expansion, so it makes this slower still.
+    search_stats stats { trace_path ? std::size_t(1) << 20 : 0 };
+    run("stored edge costs + search_stats", queries, [&](node* a, node* b) {
+        return with_heuristic(w, [&](auto h) { return A_star(g, a, b, h, ws, stats); });
+    });
+    
+    std::cout << "search_stats: " << stats.total().expanded << " expanded, " << stats.total().bytes_allocated << " bytes allocated\n";
+    
+    if (trace_path) {
+        std::ofstream trace { *trace_path };
+        stats.write_chrome_trace(trace);
+        
+        if (!trace) throw std::runtime_error { "Failed to write trace: " + *trace_path };
+    }
+    
+    
+    // Unidirectional versus bidirectional search.
+    run("bidirectional, euclidean_cost", queries, [&](node* a, node* b) { return bidirectional_A_star(g, a, b, euclidean_cost {}, ws, backward_ws); });
+    if (w.is_grid) run("bidirectional, octile_cost", queries, [&](node* a, node* b) { return bidirectional_A_star(g, a, b, octile_cost {}, ws, backward_ws); });
+    
+    
+    // ALT heuristic with 16 landmarks.
+    auto landmarks = landmark_table::build(g, 16, landmark_selection::avoid);
+    landmark_cost alt { landmarks };
+    
+    run("ALT (16 landmarks)", queries, [&](node* a, node* b) { return A_star(g, a, b, alt, ws); });
+    run("ALT (16 landmarks), bidirectional", queries, [&](node* a, node* b) { return bidirectional_A_star(g, a, b, alt, ws, backward_ws); });
+    
+    
+    // Contraction hierarchy queries. Preprocessing is not included in the query times.
+    auto ch = contraction_hierarchy::build(g);
+    run("contraction hierarchy", queries, [&](node* a, node* b) { return ch.query(g, a, b, ws, backward_ws); });
+    
+    
+    // CSR searches, over a csr_graph in memory and over the same graph written to a file and memory mapped.
+    const auto heuristic = [&](const vec2i& a, const vec2i& b) { return w.is_grid ? octile_cost {}(a, b) : euclidean_cost {}(a, b); };
+    
+    auto csr = csr_graph::from_graph(g);
+    run("csr_graph", queries, [&](node* a, node* b) { return A_star(csr, csr_graph::id_type(a->id), csr_graph::id_type(b->id), heuristic, ws); });
+    
+    const auto mapped_path = (std::filesystem::temp_directory_path() / "fp2_benchmark.graph").string();
+    mapped_graph::save(g, mapped_path);
+    
+    {
+        auto mapped = mapped_graph::load(mapped_path);
+        run("mapped_graph", queries, [&](node* a, node* b) { return A_star(mapped, mapped_graph::id_type(a->id), mapped_graph::id_type(b->id), heuristic, ws); });
+    }
+    
+    std::filesystem::remove(mapped_path);
+    
+    
+    // Grid-specific engines. The benchmark graph is a uniform-cost grid, so it is detected as one.
+    if (auto grid = grid_map::detect(g)) {
+        auto jump_table = jps_plus_table::build(*grid);
+        
+        run("jump point search", queries, [&](node* a, node* b) { return jump_point_search(*grid, a, b, ws); });
+        run("jump point search (JPS+)", queries, [&](node* a, node* b) { return jump_point_search(jump_table, a, b, ws); });
+    }
+    
+    
+    // Integer cost mode on grids: the same queries with integer_octile_cost baked into the edge costs,
+    // comparing the indexed heap with the monotone integer open sets. The original costs are restored afterwards.
+    if (w.is_grid) {
+        std::vector<std::vector<float>> original_costs;
+        for (const auto& n : g.nodes) original_costs.push_back(n->costs);
+        
+        g.bake_costs(integer_octile_cost {});
+        
+        basic_search_workspace<radix_heap_open_set<>> radix_ws;
+        basic_search_workspace<bucket_open_set<>> bucket_ws;
+        
+        run("integer costs, heap_open_set", queries, [&](node* a, node* b) { return A_star(g, a, b, integer_octile_cost {}, ws); });
+        run("integer costs, radix_heap_open_set", queries, [&](node* a, node* b) { return A_star(g, a, b, integer_octile_cost {}, radix_ws); });
+        run("integer costs, bucket_open_set", queries, [&](node* a, node* b) { return A_star(g, a, b, integer_octile_cost {}, bucket_ws); });
+        
+        for (std::size_t i = 0; i < g.nodes.size(); ++i) g.nodes[i]->costs = std::move(original_costs[i]);
+        ++g.version;
+    }
+    
+    
+    // Cached queries: the first pass fills the cache, the second pass is answered from it.
+    path_cache cache;
+    auto cached_search = [&](node* a, node* b) { return with_heuristic(w, [&](auto h) { return A_star(g, a, b, h, ws); }); };
+    
+    run("path_cache (cold)", queries, [&](node* a, node* b) { return *cache.find_or_compute(g, a, b, cached_search); });
+    run("path_cache (warm)", queries, [&](node* a, node* b) { return *cache.find_or_compute(g, a, b, cached_search); });
+    
+    
+    // Hierarchical search with 32x32 clusters. Paths are refined in full, so the path lengths are comparable to the other engines.
+    auto hierarchy = hierarchical_graph::build(g, 32);
+    run("HPA* (32x32 clusters)", queries, [&](node* a, node* b) {
+        return with_heuristic(w, [&](auto h) { return hierarchy.find_path(a, b, h).refine(); });
+    });
+    
+    
+    // Anytime search with a per-query deadline. The state is reused between queries, as it would be from frame to frame.
+    with_heuristic(w, [&](auto h) {
+        ARA_star<decltype(h)> anytime { g };
+        
+        run("ARA* (2 ms deadline)", queries, [&](node* a, node* b) {
+            anytime.begin_query(a, b);
+            return anytime.improve(std::chrono::steady_clock::now() + std::chrono::milliseconds(2)).path;
+        });
+    });
+    
+    
+    // Batched queries on a thread pool. The time per query is the wall time of the batch divided by the number of queries.
+    thread_pool pool;
+    
+    std::vector<path_query> batch;
+    for (auto [from, to] : queries) batch.push_back(path_query { from, to });
+    
+    std::vector<std::vector<node*>> results(batch.size());
+    
+    auto start = std::chrono::steady_clock::now();
+    with_heuristic(w, [&](auto h) { A_star_batch(g, batch, results, h, pool); });
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    
+    std::size_t total_length = 0;
+    for (const auto& path : results) total_length += path.size();
+    
+    print_result("A_star_batch (" + std::to_string(pool.size()) + " threads)", elapsed.count() / batch.size(), total_length);
+    
+    
+    // Distance matrices between the sources and targets of the queries: one search per pair, one search per source,
+    // and the bucket-based algorithm on the contraction hierarchy. The time is per source, the path length column is the number of entries.
+    // The matrices are checked against the costs of the paths found by the searches per pair.
+    {
+        std::vector<node*> sources, targets;
+        
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            if (i < 20) sources.push_back(queries[i].first);
+            targets.push_back(queries[i].second);
+        }
+        
+        std::vector<std::pair<node*, node*>> rows;
+        for (node* s : sources) rows.emplace_back(s, nullptr);
+        
+        // Row-major like distance_matrix::values, with unreachable pairs at infinity.
+        std::vector<double> pair_costs;
+        
+        run("matrix, A* per pair", rows, [&](node* a, node*) {
+            for (node* b : targets) {
+                auto path = with_heuristic(w, [&](auto h) { return A_star(g, a, b, h, ws); });
+                pair_costs.push_back(path.empty() ? std::numeric_limits<double>::infinity() : path_length(path));
+            }
+            
+            return targets;
+        });
+        
+        run("matrix, one_to_many per source", rows, [&](node* a, node*) {
+            return one_to_many(g, a, targets);
+        });
+        
+        
+        auto start = std::chrono::steady_clock::now();
+        auto parallel = many_to_many(g, sources, targets, pool);
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        
+        print_result("matrix, many_to_many (" + std::to_string(pool.size()) + " threads)", elapsed.count() / std::max<std::size_t>(sources.size(), 1), parallel.values.size());
+        
+        start = std::chrono::steady_clock::now();
+        auto buckets = many_to_many(ch, sources, targets, pool);
+        elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        
+        print_result("matrix, many_to_many on CH buckets", elapsed.count() / std::max<std::size_t>(sources.size(), 1), buckets.values.size());
+        
+        
+        auto mismatches = [&](const distance_matrix& m) {
+            std::size_t result = 0;
+            
+            for (std::size_t i = 0; i < pair_costs.size(); ++i) {
+                const double expected = pair_costs[i], found = m.values[i];
+                
+                if (std::isinf(expected) != std::isinf(found)) ++result;
+                else if (!std::isinf(expected) && std::abs(expected - found) > 1e-3 * std::max(1.0, expected)) ++result;
+            }
+            
+            return result;
+        };
+        
+        std::cout << "matrix entries differing from A* per pair: " << mismatches(parallel) << " (many_to_many), "
+                  << mismatches(buckets) << " (CH buckets) of " << pair_costs.size() << "\n";
+    }
+    
+    
+    // Parallel single queries with HDA*, scaling from one thread up to the number of hardware threads.
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < pool.size(); threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(pool.size());
+    
+    for (unsigned threads : thread_counts) {
+        run("HDA* (" + std::to_string(threads) + " threads)", queries, [&](node* a, node* b) {
+            return with_heuristic(w, [&](auto h) { return HDA_star(g, a, b, h, threads); });
+        });
+    }
+    
+    
+    // Single-source shortest paths from the first few query sources: sequential Dijkstra versus delta-stepping.
+    // The path length column is the total number of nodes reached. Delta-stepping is checked against Dijkstra: every node must have
+    // the same distance, and its parent must be a node through which that distance is reached (ties can give a different parent).
+    std::vector<std::pair<node*, node*>> sources { queries.begin(), queries.begin() + std::min<std::size_t>(queries.size(), 10) };
+    
+    const float delta = default_delta(g);
+    
+    std::vector<shortest_path_tree> expected;
+    
+    run("dijkstra (single source)", sources, [&](node* a, node* b) -> const auto& { return expected.emplace_back(dijkstra(g, a)).order; });
+    
+    
+    auto mismatches = [&](const shortest_path_tree& found, const shortest_path_tree& reference, const node* source) {
+        auto same = [](float a, float b) { return std::isinf(a) ? a == b : std::abs(a - b) <= 1e-4f * std::max(1.0f, std::abs(b)); };
+        std::size_t result = 0;
+        
+        for (std::size_t v = 0; v < reference.distance.size(); ++v) {
+            if (!same(found.distance[v], reference.distance[v])) {
+                ++result;
+            } else if (v != source->id && !std::isinf(reference.distance[v])) {
+                const std::uint32_t parent = found.parent[v];
+                const node* p = (parent == shortest_path_tree::no_parent) ? nullptr : g.nodes[parent].get();
+                const std::size_t edge = p ? p->edge_index(*g.nodes[v]) : 0;
+                
+                if (!p || edge == p->neighbours.size() || !same(reference.distance[parent] + p->costs[edge], reference.distance[v])) ++result;
+            }
+        }
+        
+        return result;
+    };
+    
+    for (unsigned threads : thread_counts) {
+        std::vector<shortest_path_tree> found;
+        
+        run("delta-stepping (" + std::to_string(threads) + " threads)", sources, [&](node* a, node* b) -> const auto& {
+            return found.emplace_back(delta_stepping(g, a, delta, threads)).order;
+        });
+        
+        std::size_t wrong = 0, total = 0;
+        
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            wrong += mismatches(found[i], expected[i], sources[i].first);
+            total += expected[i].distance.size();
+        }
+        
+        std::cout << "delta-stepping (" << threads << " threads) nodes differing from dijkstra: " << wrong << " / " << total << "\n";
+    }
+    
+    
+    // Incremental replanning: raise the cost of a random edge on the current path, then replan with D* Lite or with a cold A* search.
+    // Both must find paths of the same cost, so the number of replans that disagree is printed as well.
+    // The original edge costs are restored after every query.
+    with_heuristic(w, [&](auto h) {
+        std::mt19937 rng { 1 };
+        
+        double replan_time = 0, cold_time = 0;
+        std::size_t replan_length = 0, cold_length = 0, replans = 0, mismatches = 0;
+        
+        for (auto [from, to] : std::span { queries }.first(std::min<std::size_t>(queries.size(), 10))) {
+            D_star_lite<decltype(h)> planner { g, from, to };
+            auto path = planner.plan();
+            
+            std::vector<std::tuple<node*, node*, float>> changed;
+            
+            for (std::size_t i = 0; i < 20 && path.size() > 1; ++i) {
+                const std::size_t edge = std::uniform_int_distribution<std::size_t> { 0, path.size() - 2 }(rng);
+                node* a = path[edge];
+                node* b = path[edge + 1];
+                
+                const float old_cost = a->costs[a->edge_index(*b)];
+                changed.emplace_back(a, b, old_cost);
+                
+                g.set_edge_cost(*a, *b, old_cost * 4);
+                planner.edge_cost_changed(*a, *b);
+                
+                
+                auto start = std::chrono::steady_clock::now();
+                path = planner.plan();
+                replan_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                replan_length += path.size();
+                
+                start = std::chrono::steady_clock::now();
+                auto cold = A_star(g, from, to, h, ws);
+                cold_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                cold_length += cold.size();
+                
+                
+                ++replans;
+                if (path.empty() != cold.empty() || std::abs(path_length(path) - path_length(cold)) > 1e-3 * std::max(1.0, path_length(cold))) ++mismatches;
+            }
+            
+            for (auto it = changed.rbegin(); it != changed.rend(); ++it) g.set_edge_cost(*std::get<0>(*it), *std::get<1>(*it), std::get<2>(*it));
+        }
+        
+        if (replans > 0) {
+            print_result("D* Lite replan after edge change", replan_time / replans, replan_length);
+            print_result("A* cold replan after edge change", cold_time / replans, cold_length);
+            
+            std::cout << "D* Lite replans with a different cost than A*: " << mismatches << " / " << replans << "\n";
+        }
+    });
+    
+    
+    // Snapping positions to the nearest node, using the endpoints of the queries as positions.
+    {
+        auto index = spatial_index::build(g);
+        
+        auto linear_nearest = [&](vec2i position) {
+            node* result = nullptr;
+            std::int64_t best = std::numeric_limits<std::int64_t>::max();
+            
+            for (const auto& n : g.nodes) {
+                const std::int64_t dx = n->position.x - position.x, dy = n->position.y - position.y;
+                if (dx * dx + dy * dy < best) best = dx * dx + dy * dy, result = n.get();
+            }
+            
+            return result;
+        };
+        
+        run("nearest node, linear scan", queries, [&](node* a, node* b) { return std::vector<node*> { linear_nearest(a->position), linear_nearest(b->position) }; });
+        run("nearest node, spatial_index", queries, [&](node* a, node* b) { return std::vector { index.nearest(a->position), index.nearest(b->position) }; });
+        
+        
+        std::vector<vec2i> positions;
+        for (const auto& [a, b] : queries) positions.insert(positions.end(), { a->position, b->position });
+        
+        auto start = std::chrono::steady_clock::now();
+        auto snapped = index.nearest(std::span<const vec2i> { positions });
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        
+        if (!queries.empty()) print_result("nearest node, spatial_index batch", elapsed.count() / queries.size(), snapped.size());
+    }
+    
+    
+    // Loading the graph from a DIMACS edge list, with the edges in source order and shuffled. The path length column is the file size in bytes.
+    // The graph is also written with CRLF line endings and without a final newline, and loaded in small chunks so many lines
+    // cross a chunk boundary, to check the loaded graph is the same as the original.
+    {
+        const auto edge_list_path = (std::filesystem::temp_directory_path() / "fp2_benchmark.gr").string();
+        const auto expected = csr_graph::from_graph(g);
+        
+        for (bool shuffled : { false, true }) {
+            write_edge_list(g, edge_list_path, shuffled, "\n", true);
+            const auto bytes = std::filesystem::file_size(edge_list_path);
+            
+            auto start = std::chrono::steady_clock::now();
+            auto loaded = load_edge_list(edge_list_path, pool);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            
+            std::cout << std::left << std::setw(40) << (shuffled ? "load_edge_list (shuffled edges)" : "load_edge_list (edges by source)")
+                      << std::right << std::setw(12) << std::fixed << std::setprecision(2) << (bytes / 1e6) / seconds << " MB/s"
+                      << "       (" << bytes << " bytes" << (same_graph(loaded, expected) ? "" : ", DIFFERENT FROM THE ORIGINAL") << ")\n";
+        }
+        
+        write_edge_list(g, edge_list_path, true, "\r\n", false);
+        const bool round_trip = same_graph(load_edge_list(edge_list_path, pool, 4096), expected);
+        
+        std::cout << "load_edge_list round trip (CRLF, 4 KiB chunks, no final newline): " << (round_trip ? "ok" : "DIFFERENT FROM THE ORIGINAL") << "\n";
+        
+        std::filesystem::remove(edge_list_path);
+    }
+    
+    
+    // Node orderings, starting from a random order to simulate badly ordered input. BFS and Cuthill-McKee depend on the order they start from,
+    // so every strategy is applied to the same random order of the original nodes. The original order is restored afterwards.
+    {
+        const std::vector<node*> original_order = [&] {
+            std::vector<node*> result;
+            for (const auto& n : g.nodes) result.push_back(n.get());
+            return result;
+        }();
+        
+        auto run_order = [&](const std::string& name) {
+            auto csr = csr_graph::from_graph(g);
+            const auto heuristic = [&](const vec2i& a, const vec2i& b) { return w.is_grid ? octile_cost {}(a, b) : euclidean_cost {}(a, b); };
+            
+            run("order: " + name, queries, [&](node* a, node* b) { return w.is_grid ? A_star(g, a, b, octile_cost {}, ws) : A_star(g, a, b, euclidean_cost {}, ws); });
+            run("order: " + name + ", csr_graph", queries, [&](node* a, node* b) { return A_star(csr, csr_graph::id_type(a->id), csr_graph::id_type(b->id), heuristic, ws); });
+        };
+        
+        
+        auto restore_original = [&] {
+            std::vector<std::size_t> new_ids(g.nodes.size());
+            for (std::size_t i = 0; i < original_order.size(); ++i) new_ids[original_order[i]->id] = i;
+            
+            permute_nodes(g, new_ids);
+        };
+        
+        
+        std::vector<std::size_t> shuffled(g.nodes.size());
+        std::iota(shuffled.begin(), shuffled.end(), std::size_t(0));
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937 { 1 });
+        
+        permute_nodes(g, shuffled);
+        run_order("random");
+        
+        for (auto [order, name] : { std::pair { node_order::hilbert, "hilbert" }, { node_order::bfs, "bfs" }, { node_order::cuthill_mckee, "cuthill-mckee" }, { node_order::degree, "degree" } }) {
+            restore_original();
+            permute_nodes(g, shuffled);
+            reorder_nodes(g, order);
+            run_order(name);
+        }
+        
+        restore_original();
+    }
+    
+    
+    std::cout << "\n";
+}
+
+
+std::vector<query> random_queries(const std::vector<node*>& candidates, std::size_t count, unsigned seed) {
+    std::vector<query> result;
+    
+    for (auto [from, to] : bench::random_queries(candidates, count, seed)) {
+        result.push_back(query { from, to, std::numeric_limits<double>::quiet_NaN() });
+    }
+    
+    return result;
+}
+
+
+workload load_movingai(const std::string& map_path, const std::optional<std::string>& scen_path, std::size_t count, unsigned seed) {
+    workload result { .name = map_path, .g = {}, .queries = {}, .is_grid = true };
+    
+    auto map  = bench::load_map(map_path);
+    auto grid = map.to_graph(result.g);
+    
+    
+    if (scen_path) {
+        // Queries whose start or goal is blocked are kept with null nodes, so they are reported as failed.
+        for (const auto& s : bench::load_scenarios(*scen_path)) {
+            result.queries.push_back(query { grid.at(s.start.x, s.start.y), grid.at(s.goal.x, s.goal.y), s.optimal_length });
+        }
+    } else {
+        std::vector<node*> candidates;
+        for (const auto& n : result.g.nodes) candidates.push_back(n.get());
+        
+        result.queries = random_queries(candidates, count, seed);
+    }
+    
+    
+    return result;
+}
+
+
+std::string json_string(std::string_view s) {
+    std::string result = "\"";
+    
+    for (char c : s) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    
+    return result + "\"";
+}
+
+
+// Runs every query of the workload through A_star and writes the results as a JSON object.
+void run_workload(workload& w, std::ostream& out) {
+    using ws_type = basic_search_workspace<bench::counting_open_set<>>;
+    ws_type ws;
+    
+    
+    std::vector<double> latencies, expansions;
+    std::size_t failed = 0, suboptimal = 0, edges = 0;
+    
+    for (const auto& n : w.g.nodes) edges += n->neighbours.size();
+    edges /= 2;
+    
+    
+    const auto start = std::chrono::steady_clock::now();
+    
+    for (const auto& q : w.queries) {
+        if (!q.from || !q.to) {
+            ++failed;
+            continue;
+        }
+        
+        const auto query_start = std::chrono::steady_clock::now();
+        
+        auto path = w.is_grid
+            ? A_star(w.g, q.from, q.to, octile_cost {}, ws)
+            : A_star(w.g, q.from, q.to, euclidean_cost {}, ws);
+        
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - query_start).count());
+        expansions.push_back(double(ws.open.expanded));
+        
+        
+        if (path.empty()) {
+            ++failed;
+        } else if (!std::isnan(q.optimal_length)) {
+            // Scenario lengths are given with limited precision.
+            if (std::abs(path_length(path) - q.optimal_length) > 1e-3 * std::max(1.0, q.optimal_length)) ++suboptimal;
+        }
+    }
+    
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    
+    const auto latency  = bench::summary::of(latencies);
+    const auto expanded = bench::summary::of(expansions);
+    
+    out << "    {\n"
+        << "      \"name\": " << json_string(w.name) << ",\n"
+        << "      \"nodes\": " << w.g.nodes.size() << ",\n"
+        << "      \"edges\": " << edges << ",\n"
+        << "      \"queries\": " << w.queries.size() << ",\n"
+        << "      \"failed\": " << failed << ",\n"
+        << "      \"suboptimal\": " << suboptimal << ",\n"
+        << "      \"seconds\": " << seconds << ",\n"
+        << "      \"throughput_qps\": " << (seconds > 0 ? double(latencies.size()) / seconds : 0.0) << ",\n"
+        << "      \"latency_us\": { \"mean\": " << latency.mean << ", \"p50\": " << latency.p50 << ", \"p99\": " << latency.p99 << ", \"max\": " << latency.max << " },\n"
+        << "      \"expanded\": { \"mean\": " << expanded.mean << ", \"p50\": " << expanded.p50 << ", \"p99\": " << expanded.p99 << ", \"max\": " << expanded.max << " }\n"
+        << "    }";
+}
+
+
+// Parses a numeric argument, which must consist of only the number.
+template <typename T> T parse_number(std::string_view arg) {
+    T result {};
+    auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), result);
+    
+    if (error != std::errc {} || end != arg.data() + arg.size()) throw std::invalid_argument { "Invalid number: " + std::string { arg } };
+    return result;
+}
+
+
+int main(int argc, char** argv) {
+    std::vector<std::string_view> args { argv + 1, argv + argc };
+    
+    std::size_t count = 1000;
+    unsigned seed = 1;
+    bool compare = false;
+    std::optional<std::string> trace_path;
+    
+    
+    std::vector<workload> workloads;
+    
+    auto make_synthetic = [&](std::string name, auto&& generate) {
+        workload w { .name = std::move(name), .g = {}, .queries = {}, .is_grid = false };
+        w.queries = random_queries(generate(w.g), count, seed + 1);
+        
+        return w;
+    };
+    
+    try {
+        // Options are parsed first, since they apply to every workload.
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--queries" && i + 1 < args.size()) count = parse_number<std::size_t>(args[++i]);
+            else if (args[i] == "--seed" && i + 1 < args.size()) seed = parse_number<unsigned>(args[++i]);
+            else if (args[i] == "--compare") compare = true;
+            else if (args[i] == "--trace" && i + 1 < args.size()) trace_path = std::string { args[++i] };
+        }
+        
+        
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            auto remaining = args.size() - i - 1;
+            auto arg = [&](std::size_t n) { return std::string { args[i + n] }; };
+            
+            if (args[i] == "--map" && remaining >= 1) {
+                std::optional<std::string> scen;
+                if (remaining >= 3 && args[i + 2] == "--scen") scen = arg(3);
+                
+                workloads.push_back(load_movingai(arg(1), scen, count, seed));
+                i += scen ? 3 : 1;
+            } else if (args[i] == "--grid" && remaining >= 3) {
+                int width = parse_number<int>(args[i + 1]), height = parse_number<int>(args[i + 2]);
+                float blocked = parse_number<float>(args[i + 3]);
+                
+                workloads.push_back(make_synthetic("grid " + arg(1) + "x" + arg(2) + " blocked " + arg(3), [&](graph& g) {
+                    return bench::make_grid(g, width, height, blocked, seed);
+                }));
+                
+                workloads.back().is_grid = true;
+                i += 3;
+            } else if (args[i] == "--geometric" && remaining >= 2) {
+                std::size_t nodes = parse_number<std::size_t>(args[i + 1]);
+                float radius = parse_number<float>(args[i + 2]);
+                
+                workloads.push_back(make_synthetic("geometric " + arg(1) + " radius " + arg(2), [&](graph& g) {
+                    return bench::make_geometric(g, nodes, radius, seed);
+                }));
+                
+                i += 2;
+            } else if (args[i] == "--queries" || args[i] == "--seed" || args[i] == "--trace") {
+                ++i;
+            } else if (args[i] != "--compare") {
+                throw std::invalid_argument { "Unknown or incomplete argument: " + arg(0) };
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    
+    
+    if (workloads.empty()) {
+        workloads.push_back(make_synthetic("grid 512x512 blocked 0.2", [&](graph& g) { return bench::make_grid(g, 512, 512, 0.2f, seed); }));
+        workloads.back().is_grid = true;
+    }
+    
+    
+    if (compare) {
+        for (std::size_t i = 0; i < workloads.size(); ++i) compare_engines(workloads[i], i == 0 ? trace_path : std::nullopt);
+        return EXIT_SUCCESS;
+    }
+    
+    
+    std::cout << "{\n  \"workloads\": [\n";
+    
+    for (std::size_t i = 0; i < workloads.size(); ++i) {
+        run_workload(workloads[i], std::cout);
+        std::cout << (i + 1 < workloads.size() ? ",\n" : "\n");
+    }
+    
+    std::cout << "  ],\n  \"peak_memory_bytes\": " << bench::peak_memory_usage() << "\n}\n";
+}
\ No newline at end of file
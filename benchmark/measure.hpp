@@ -0,0 +1,86 @@
+#pragma once
+
+#include <imperative/open_set.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstddef>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+
+namespace bench {
+    // Wraps an open set policy to count how many nodes a search expands.
+    // Every node that is popped from the open set is counted, so the count of a successful search includes the goal.
+    template <typename OpenSet = imp::heap_open_set>
+    class counting_open_set : public OpenSet {
+    public:
+        void reset(std::size_t nodes) {
+            expanded = 0;
+            OpenSet::reset(nodes);
+        }
+        
+        
+        std::size_t pop(void) {
+            ++expanded;
+            return OpenSet::pop();
+        }
+        
+        
+        std::size_t expanded = 0;
+    };
+    
+    
+    // Peak resident memory of this process in bytes, or 0 if it is not available on this platform.
+    inline std::size_t peak_memory_usage(void) {
+        #if defined(_WIN32)
+            PROCESS_MEMORY_COUNTERS counters;
+            if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+            
+            return counters.PeakWorkingSetSize;
+        #else
+            rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+            
+            // ru_maxrss is in bytes on macOS, and in kilobytes everywhere else.
+            #if defined(__APPLE__)
+                return std::size_t(usage.ru_maxrss);
+            #else
+                return std::size_t(usage.ru_maxrss) * 1024;
+            #endif
+        #endif
+    }
+    
+    
+    // Summary statistics for a list of samples.
+    struct summary {
+        double mean = 0, p50 = 0, p99 = 0, max = 0;
+        
+        
+        static summary of(std::vector<double> samples) {
+            if (samples.empty()) return {};
+            std::sort(samples.begin(), samples.end());
+            
+            // Nearest-rank percentiles.
+            auto percentile = [&](double p) {
+                std::size_t rank = std::size_t(std::ceil(p * samples.size()));
+                return samples[std::clamp<std::size_t>(rank, 1, samples.size()) - 1];
+            };
+            
+            return summary {
+                .mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size(),
+                .p50  = percentile(0.50),
+                .p99  = percentile(0.99),
+                .max  = samples.back()
+            };
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/grid_map.hpp>
+#include <imperative/common.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace bench {
+    // Map in the MovingAI benchmark format (https://movingai.com/benchmarks/formats.html):
+    //
+    // type octile
+    // height <h>
+    // width <w>
+    // map
+    // <h rows of w tiles>
+    struct movingai_map {
+        int width = 0, height = 0;
+        std::vector<std::string> rows;
+        
+        
+        // Only ground tiles are passable. Water, trees and out of bounds tiles are treated as obstacles.
+        bool passable(int x, int y) const {
+            char tile = rows[y][x];
+            return tile == '.' || tile == 'G' || tile == 'S';
+        }
+        
+        
+        // Adds the map to g as an 8-connected grid without corner cutting, which is the movement model used by the scenario files.
+        imp::grid_map to_graph(imp::graph& g) const {
+            return imp::grid_map::create(g, width, height, [&](int x, int y) { return passable(x, y); });
+        }
+    };
+    
+    
+    inline movingai_map load_map(const std::string& path) {
+        std::ifstream stream { path };
+        if (!stream) throw std::runtime_error { "Failed to open map file: " + path };
+        
+        movingai_map result;
+        
+        
+        std::string key;
+        while (stream >> key && key != "map") {
+            if (key == "height") stream >> result.height;
+            else if (key == "width") stream >> result.width;
+            else std::getline(stream, key);
+        }
+        
+        if (key != "map" || result.width <= 0 || result.height <= 0) throw std::runtime_error { "Invalid map header: " + path };
+        
+        
+        result.rows.resize(result.height);
+        
+        for (auto& row : result.rows) {
+            stream >> row;
+            if (int(row.size()) != result.width) throw std::runtime_error { "Map file is truncated: " + path };
+        }
+        
+        return result;
+    }
+    
+    
+    // A single query from a MovingAI .scen file. optimal_length is the length of the shortest path given by the benchmark.
+    struct movingai_scenario {
+        int bucket;
+        std::string map;
+        imp::vec2i start, goal;
+        double optimal_length;
+    };
+    
+    
+    // Scenario file format: a "version 1" line, followed by one line per query:
+    // <bucket> <map> <map width> <map height> <start x> <start y> <goal x> <goal y> <optimal length>
+    inline std::vector<movingai_scenario> load_scenarios(const std::string& path) {
+        std::ifstream stream { path };
+        if (!stream) throw std::runtime_error { "Failed to open scenario file: " + path };
+        
+        std::string line;
+        if (!std::getline(stream, line) || line.rfind("version", 0) != 0) throw std::runtime_error { "Invalid scenario header: " + path };
+        
+        
+        std::vector<movingai_scenario> result;
+        
+        while (std::getline(stream, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            
+            std::istringstream fields { line };
+            movingai_scenario s;
+            int width, height;
+            
+            fields >> s.bucket >> s.map >> width >> height >> s.start.x >> s.start.y >> s.goal.x >> s.goal.y >> s.optimal_length;
+            if (!fields) throw std::runtime_error { "Invalid scenario line in " + path + ": " + line };
+            
+            result.push_back(std::move(s));
+        }
+        
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/grid_map.hpp>
+
+#include <vector>
+#include <random>
+#include <string>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace bench {
+    // Creates an 8-connected width x height grid in g, where each cell is blocked with the given probability.
+    // Diagonal edges are only added if both adjacent orthogonal cells are open.
+    // Returns the node for each cell in row-major order, or nullptr for blocked cells.
+    inline std::vector<imp::node*> make_grid(imp::graph& g, int width, int height, float blocked, unsigned seed) {
+        std::mt19937 rng { seed };
+        std::bernoulli_distribution is_blocked { blocked };
+        
+        auto grid = imp::grid_map::create(g, width, height, [&](int x, int y) { return !is_blocked(rng); });
+        
+        std::vector<imp::node*> cells;
+        cells.reserve(std::size_t(width) * height);
+        
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) cells.push_back(grid.at(x, y));
+        }
+        
+        return cells;
+    }
+    
+    
+    // Creates a random geometric graph in g: count nodes are placed uniformly in a square, and every pair of nodes
+    // closer than radius is connected. The square has a side of 100 * sqrt(count), so the average degree only depends on radius
+    // (roughly pi * radius^2 / 100^2, i.e. about 7 for a radius of 150).
+    inline std::vector<imp::node*> make_geometric(imp::graph& g, std::size_t count, float radius, unsigned seed) {
+        std::mt19937 rng { seed };
+        
+        const int side = std::max(1, int(100 * std::sqrt(double(count))));
+        std::uniform_int_distribution<int> coordinate { 0, side - 1 };
+        
+        std::vector<imp::node*> result;
+        result.reserve(count);
+        
+        for (std::size_t i = 0; i < count; ++i) {
+            result.push_back(&g.add_node(std::to_string(i), { coordinate(rng), coordinate(rng) }));
+        }
+        
+        
+        // Bucket the nodes into cells of radius x radius, so only neighbouring buckets have to be checked.
+        const int cell_size = std::max(1, int(std::ceil(radius)));
+        const int cells = side / cell_size + 1;
+        
+        std::vector<std::vector<imp::node*>> buckets(std::size_t(cells) * cells);
+        auto bucket_of = [&](imp::vec2i p) { return std::size_t(p.y / cell_size) * cells + std::size_t(p.x / cell_size); };
+        
+        for (auto* n : result) buckets[bucket_of(n->position)].push_back(n);
+        
+        
+        for (auto* n : result) {
+            const int bx = n->position.x / cell_size, by = n->position.y / cell_size;
+            
+            for (int y = std::max(by - 1, 0); y <= std::min(by + 1, cells - 1); ++y) {
+                for (int x = std::max(bx - 1, 0); x <= std::min(bx + 1, cells - 1); ++x) {
+                    for (auto* other : buckets[std::size_t(y) * cells + x]) {
+                        // Each pair is seen from both sides, so only add the edge once.
+                        if (other->id <= n->id || imp::distance(n->position, other->position) > radius) continue;
+                        g.add_edge(*n, *other);
+                    }
+                }
+            }
+        }
+        
+        
+        return result;
+    }
+    
+    
+    // Picks count random (from, to) pairs from the non-null nodes in candidates. Throws std::invalid_argument if there are none.
+    inline std::vector<std::pair<imp::node*, imp::node*>> random_queries(const std::vector<imp::node*>& candidates, std::size_t count, unsigned seed) {
+        std::vector<imp::node*> nodes;
+        for (auto* n : candidates) if (n) nodes.push_back(n);
+        
+        if (nodes.empty()) throw std::invalid_argument { "Cannot pick random queries from a graph without nodes." };
+        
+        std::mt19937 rng { seed };
+        std::uniform_int_distribution<std::size_t> pick { 0, nodes.size() - 1 };
+        
+        std::vector<std::pair<imp::node*, imp::node*>> result;
+        for (std::size_t i = 0; i < count; ++i) result.emplace_back(nodes[pick(rng)], nodes[pick(rng)]);
+        
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/container/indexed_heap.hpp>
+
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // The best path found so far by an anytime search.
+    struct anytime_path {
+        std::vector<node*> path;
+        float cost = std::numeric_limits<float>::infinity();
+        // The cost of path is at most bound times the cost of the optimal path. Infinite if no path has been found yet.
+        float bound = std::numeric_limits<float>::infinity();
+    };
+    
+    
+    // Anytime repairing A* (Likhachev, Gordon & Thrun), for queries with a deadline.
+    // The search starts with the heuristic inflated by initial_epsilon, which quickly finds a path that is at most epsilon times
+    // as expensive as the optimal one. epsilon is then lowered by epsilon_step at a time (or straight to 1 if it is 0), and every following iteration
+    // only re-expands the nodes whose cost has improved since they were last expanded, rather than starting over.
+    //
+    // The search can be suspended at any point by a deadline or an expansion budget, and continued by calling improve again.
+    // The per-node state is stamped with the query that wrote it, so an ARA_star can be reused for new queries through begin_query
+    // without clearing it, like a search_workspace. Edge costs are read from the graph, which must not be changed while the search is in use.
+    // The heuristic must be consistent; euclidean_cost is, as long as no edge is cheaper than its length.
+    template <CostPolicy Heuristic = euclidean_cost>
+    class ARA_star {
+    public:
+        using clock = std::chrono::steady_clock;
+        
+        
+        explicit ARA_star(const graph& g, Heuristic h = Heuristic {}, float initial_epsilon = 3.0f, float epsilon_step = 0.5f) :
+            g(&g),
+            h(std::move(h)),
+            initial_epsilon(std::max(initial_epsilon, 1.0f)),
+            epsilon_step(std::max(epsilon_step, 0.0f)),
+            records(g.nodes.size()),
+            open(g.nodes.size())
+        {}
+        
+        
+        ARA_star(const graph& g, node* from, node* to, Heuristic h = Heuristic {}, float initial_epsilon = 3.0f, float epsilon_step = 0.5f) :
+            ARA_star(g, std::move(h), initial_epsilon, epsilon_step)
+        {
+            begin_query(from, to);
+        }
+        
+        
+        // Starts a new search, discarding the state of the previous one.
+        void begin_query(node* from, node* to) {
+            this->from = from;
+            this->to   = to;
+            
+            epsilon  = initial_epsilon;
+            solution = anytime_path {};
+            finished = false;
+            
+            open.clear();
+            inconsistent_list.clear();
+            
+            if (++generation == 0) {
+                // The generation counter wrapped around, so old stamps could appear valid again.
+                for (auto& r : records) r = record {};
+                generation = 1;
+            }
+            
+            next_iteration();
+            
+            set_gscore(from->id, 0, no_parent);
+            open.push(from->id, fscore(from->id));
+        }
+        
+        
+        // Continues the search until the deadline passes, max_expansions more nodes have been expanded,
+        // or the optimal path has been found. Returns the best path found so far.
+        const anytime_path& improve(clock::time_point deadline, std::size_t max_expansions = std::numeric_limits<std::size_t>::max()) {
+            std::size_t expansions = 0;
+            
+            while (!finished && improve_path(deadline, max_expansions, expansions)) {
+                publish();
+                
+                // The search is complete once the path is optimal, or once the goal could not be reached even with the current epsilon.
+                if (epsilon == 1.0f || solution.bound <= 1.0f || gscore(to->id) == infinity) {
+                    finished = true;
+                    break;
+                }
+                
+                lower_epsilon();
+            }
+            
+            return solution;
+        }
+        
+        
+        const anytime_path& improve(std::size_t max_expansions) {
+            return improve(clock::time_point::max(), max_expansions);
+        }
+        
+        
+        const anytime_path& get_solution(void) const { return solution; }
+        float get_epsilon(void) const { return epsilon; }
+        
+        // True once the search has either proven its path optimal or shown there is no path at all.
+        bool is_finished(void) const { return finished; }
+    private:
+        constexpr static float infinity = std::numeric_limits<float>::infinity();
+        constexpr static std::uint32_t no_parent = std::numeric_limits<std::uint32_t>::max();
+        
+        // The clock is only checked every this many expansions.
+        constexpr static std::size_t expansions_per_clock_check = 64;
+        
+        
+        // gscore and parent are only valid if generation matches the current query.
+        // A node is closed or inconsistent if its stamp equals the current iteration, so they don't have to be cleared between iterations.
+        // Inconsistent nodes improved after being expanded in this iteration, and are only reopened in the next one.
+        struct record {
+            std::uint32_t generation = 0;
+            float gscore;
+            std::uint32_t parent;
+            std::uint32_t closed = 0, inconsistent = 0;
+        };
+        
+        
+        const graph* g;
+        node* from = nullptr;
+        node* to = nullptr;
+        
+        Heuristic h;
+        float initial_epsilon, epsilon_step;
+        float epsilon = 1.0f;
+        
+        std::vector<record> records;
+        std::vector<std::uint32_t> inconsistent_list;
+        std::uint32_t generation = 0, iteration = 0;
+        
+        indexed_heap<float, 4> open;
+        
+        anytime_path solution;
+        bool finished = true;
+        
+        
+        float gscore(std::size_t n) const {
+            return records[n].generation == generation ? records[n].gscore : infinity;
+        }
+        
+        void set_gscore(std::size_t n, float gscore, std::uint32_t parent) {
+            records[n].generation = generation;
+            records[n].gscore = gscore;
+            records[n].parent = parent;
+        }
+        
+        float fscore(std::size_t n) const {
+            return gscore(n) + epsilon * h.cost(g->nodes[n].get(), to);
+        }
+        
+        
+        void next_iteration(void) {
+            if (++iteration == 0) {
+                for (auto& r : records) r.closed = r.inconsistent = 0;
+                iteration = 1;
+            }
+        }
+        
+        
+        // Expands nodes until the path to the goal is within epsilon of the optimal one.
+        // Returns false if the deadline or expansion budget ran out first.
+        bool improve_path(clock::time_point deadline, std::size_t max_expansions, std::size_t& expansions) {
+            while (!open.empty() && fscore(to->id) > open.top().key) {
+                if (expansions >= max_expansions) return false;
+                if (expansions % expansions_per_clock_check == 0 && clock::now() >= deadline) return false;
+                
+                ++expansions;
+                
+                
+                const std::size_t u = open.pop();
+                records[u].closed = iteration;
+                
+                const node* current = g->nodes[u].get();
+                
+                for (std::size_t i = 0; i < current->neighbours.size(); ++i) {
+                    const std::size_t v = current->neighbours[i]->id;
+                    const float tentative_gscore = gscore(u) + current->costs[i];
+                    
+                    if (tentative_gscore >= gscore(v)) continue;
+                    
+                    set_gscore(v, tentative_gscore, std::uint32_t(u));
+                    
+                    if (records[v].closed != iteration) {
+                        open.push_or_update(v, fscore(v));
+                    } else if (records[v].inconsistent != iteration) {
+                        records[v].inconsistent = iteration;
+                        inconsistent_list.push_back(std::uint32_t(v));
+                    }
+                }
+            }
+            
+            return true;
+        }
+        
+        
+        // Stores the path found by the last iteration, with a bound that may be tighter than epsilon.
+        void publish(void) {
+            if (gscore(to->id) == infinity) return;
+            
+            
+            // Every node on the optimal path that has not been expanded with its optimal cost yet is open or inconsistent,
+            // so the lowest unweighted fscore among them is a lower bound on the optimal cost.
+            float lower_bound = gscore(to->id);
+            
+            for (const auto& e : open.entries()) lower_bound = std::min(lower_bound, gscore(e.index) + h.cost(g->nodes[e.index].get(), to));
+            for (std::uint32_t n : inconsistent_list) lower_bound = std::min(lower_bound, gscore(n) + h.cost(g->nodes[n].get(), to));
+            
+            
+            solution.path.clear();
+            for (std::uint32_t n = std::uint32_t(to->id); n != no_parent; n = records[n].parent) solution.path.push_back(g->nodes[n].get());
+            
+            std::reverse(solution.path.begin(), solution.path.end());
+            
+            
+            // Nodes on the path may have improved after their successor was last relaxed, so the path can be cheaper than the gscore of the goal.
+            solution.cost = 0;
+            
+            for (std::size_t i = 1; i < solution.path.size(); ++i) {
+                const node* previous = solution.path[i - 1];
+                solution.cost += previous->costs[previous->edge_index(*solution.path[i])];
+            }
+            
+            solution.bound = solution.cost > lower_bound ? std::min(epsilon, solution.cost / lower_bound) : 1.0f;
+        }
+        
+        
+        // Moves to the next iteration: inconsistent nodes are reopened, and every open node is reinserted with the new epsilon.
+        void lower_epsilon(void) {
+            epsilon = epsilon_step > 0 ? std::max(epsilon - epsilon_step, 1.0f) : 1.0f;
+            
+            std::vector<std::uint32_t> reopened = std::move(inconsistent_list);
+            for (const auto& e : open.entries()) reopened.push_back(std::uint32_t(e.index));
+            
+            open.clear();
+            inconsistent_list.clear();
+            
+            next_iteration();
+            
+            for (std::uint32_t n : reopened) open.push_or_update(n, fscore(n));
+        }
+    };
+}
\ No newline at end of file
@@ -2,29 +2,18 @@
 
 #include <imperative/graph.hpp>
 #include <imperative/cost_function.hpp>
+#include <imperative/open_set.hpp>
+#include <imperative/csr_graph.hpp>
+#include <imperative/search_workspace.hpp>
+#include <imperative/search_stats.hpp>
 
 #include <vector>
 #include <unordered_map>
-#include <map>
-#include <set>
-#include <queue>
 #include <algorithm>
 #include <limits>
 
 
 namespace imp {
-    class score_comparator {
-    public:
-        explicit score_comparator(std::unordered_map<node*, float>* scores) : scores(scores) {}
-        
-        bool operator()(node* a, node* b) const {
-            return scores->at(a) < scores->at(b);
-        }
-    private:
-        std::unordered_map<node*, float>* scores;
-    };
-    
-    
     inline std::vector<node*> reconstruct_path(const std::unordered_map<node*, node*>& came_from, node* current) {
         std::vector<node*> result { current };
         
@@ -39,43 +28,222 @@ namespace imp {
     }
     
     
-    inline std::vector<node*> A_star(graph& g, node* from, node* to, cost_function& h, cost_function& d) {
-        const float infinity = std::numeric_limits<float>::infinity();
+    template <typename OpenSet>
+    inline std::vector<node*> reconstruct_path(const graph& g, const basic_search_workspace<OpenSet>& ws, node* current) {
+        std::vector<node*> result;
+        
+        for (auto id : ws.path_to(current->id)) result.push_back(g.nodes[id].get());
+        return result;
+    }
+    
+    
+    namespace detail {
+        // Bytes by which ws has grown since its memory usage was initial, which searches report to their stats as allocated.
+        // The open set can also shrink between queries, in which case nothing was allocated.
+        template <typename OpenSet> inline std::size_t workspace_growth(const basic_search_workspace<OpenSet>& ws, std::size_t initial) {
+            const std::size_t current = ws.memory_usage();
+            return current > initial ? current - initial : 0;
+        }
+        
+        
+        // Shared implementation of the imp::graph overloads of A_star.
+        // edge_cost is invoked with a node and the index of one of its neighbours.
+        template <typename OpenSet, typename Heuristic, typename EdgeCost, SearchStats Stats>
+        inline std::vector<node*> A_star_impl(const graph& g, node* from, node* to, Heuristic& h, EdgeCost&& edge_cost, basic_search_workspace<OpenSet>& ws, Stats& stats) {
+            using ws_type = basic_search_workspace<OpenSet>;
+            
+            
+            stats.begin_query();
+            stats.begin_phase(search_phase::setup);
+            
+            const std::size_t workspace_size = ws.memory_usage();
+            
+            ws.begin_query(g.nodes.size());
+            ws.visit(from->id, 0, ws_type::no_parent);
+            ws.open.push_or_update(from->id, h.cost(from, to));
+            
+            stats.heuristic_evaluated();
+            stats.pushed(ws.open.size());
+            stats.end_phase(search_phase::setup);
+            
+            
+            stats.begin_phase(search_phase::search);
+            
+            while (!ws.open.empty()) {
+                node* current = g.nodes[ws.open.pop()].get();
+                stats.expanded(current->id, ws.open.size());
+                
+                if (current == to) {
+                    stats.allocated(workspace_growth(ws, workspace_size));
+                    stats.end_phase(search_phase::search);
+                    stats.begin_phase(search_phase::reconstruct);
+                    
+                    auto path = reconstruct_path(g, ws, current);
+                    
+                    stats.allocated(path.capacity() * sizeof(node*));
+                    stats.end_phase(search_phase::reconstruct);
+                    stats.end_query(true);
+                    
+                    return path;
+                }
+                
+                const float current_gscore = ws.gscore(current->id);
+                
+                
+                for (std::size_t i = 0; i < current->neighbours.size(); ++i) {
+                    node* neighbour = current->neighbours[i];
+                    float tentative_gscore = current_gscore + edge_cost(current, i);
+                    
+                    stats.relaxed();
+                    
+                    
+                    if (tentative_gscore < ws.gscore(neighbour->id)) {
+                        if (ws.visited(neighbour->id)) stats.decreased_key();
+                        
+                        ws.visit(neighbour->id, tentative_gscore, std::uint32_t(current->id));
+                        ws.open.push_or_update(neighbour->id, tentative_gscore + h.cost(neighbour, to));
+                        
+                        stats.heuristic_evaluated();
+                        stats.pushed(ws.open.size());
+                    }
+                }
+            }
+            
+            
+            stats.allocated(workspace_growth(ws, workspace_size));
+            stats.end_phase(search_phase::search);
+            stats.end_query(false);
+            
+            return {};
+        }
+    }
+    
+    
+    // Searches g using the dense arrays in ws. Only nodes that are reached by the search are touched,
+    // so reusing the same workspace between queries avoids any per-query O(V) setup.
+    // g is only read, so any number of threads may search the same graph concurrently, as long as each uses its own workspace.
+    // The cost of each edge is computed using d.
+    //
+    // h and d can be any CostPolicy. When they are passed as their concrete type their calls are inlined,
+    // when they are passed as a cost_function& they are invoked virtually.
+    //
+    // Passing a search_stats object as stats reports what the search did (see search_stats.hpp).
+    // By default null_stats is used, which adds no overhead.
+    template <typename OpenSet, CostPolicy H, CostPolicy D, SearchStats Stats = null_stats>
+    inline std::vector<node*> A_star(const graph& g, node* from, node* to, H&& h, D&& d, basic_search_workspace<OpenSet>& ws, Stats&& stats = Stats {}) {
+        return detail::A_star_impl(g, from, to, h, [&](node* current, std::size_t i) { return d.cost(current, current->neighbours[i]); }, ws, stats);
+    }
+    
+    
+    // OpenSet can be any of the policies in open_set.hpp, e.g. A_star<multiset_open_set>(...).
+    // Prefer the overload taking a workspace when performing many queries.
+    template <typename OpenSet = heap_open_set, CostPolicy H, CostPolicy D>
+    inline std::vector<node*> A_star(const graph& g, node* from, node* to, H&& h, D&& d) {
+        basic_search_workspace<OpenSet> ws;
+        return A_star(g, from, to, h, d, ws);
+    }
+    
+    
+    // Overloads without a traversal cost function use the edge costs stored in the graph (see graph::add_edge and graph::bake_costs).
+    template <typename OpenSet, CostPolicy H, SearchStats Stats = null_stats>
+    inline std::vector<node*> A_star(const graph& g, node* from, node* to, H&& h, basic_search_workspace<OpenSet>& ws, Stats&& stats = Stats {}) {
+        return detail::A_star_impl(g, from, to, h, [](node* current, std::size_t i) { return current->costs[i]; }, ws, stats);
+    }
     
+    
+    template <typename OpenSet = heap_open_set, CostPolicy H>
+    inline std::vector<node*> A_star(const graph& g, node* from, node* to, H&& h) {
+        basic_search_workspace<OpenSet> ws;
+        return A_star(g, from, to, h, ws);
+    }
+    
+    
+    // A* over a csr_graph or another CsrGraph, using the stored edge costs. The heuristic is invoked with the positions of two nodes.
+    template <CsrGraph G, typename Heuristic, typename OpenSet, SearchStats Stats = null_stats>
+    inline std::vector<csr_graph::id_type> A_star(const G& g, csr_graph::id_type from, csr_graph::id_type to, Heuristic&& h, basic_search_workspace<OpenSet>& ws, Stats&& stats = Stats {}) {
+        using id_type = csr_graph::id_type;
+        using ws_type = basic_search_workspace<OpenSet>;
+        
+        
+        const vec2i target = g.position(to);
         
-        std::unordered_map<node*, node*> came_from;
-        std::unordered_map<node*, float> fscore, gscore;
-        std::multiset<node*, score_comparator> discovered { score_comparator { &fscore } };
+        stats.begin_query();
+        stats.begin_phase(search_phase::setup);
         
+        const std::size_t workspace_size = ws.memory_usage();
         
-        for (auto& node : g.nodes) gscore[node.get()] = fscore[node.get()] = infinity;
-        gscore[from] = 0;
-        fscore[from] = h.cost(from, to);
+        ws.begin_query(g.node_count());
+        ws.visit(from, 0, ws_type::no_parent);
+        ws.open.push_or_update(from, h(g.position(from), target));
         
-        discovered.insert(from);
+        stats.heuristic_evaluated();
+        stats.pushed(ws.open.size());
+        stats.end_phase(search_phase::setup);
         
         
-        while (!discovered.empty()) {
-            node* current = discovered.extract(discovered.begin()).value();
-            if (current == to) return reconstruct_path(came_from, current);
+        stats.begin_phase(search_phase::search);
         
+        while (!ws.open.empty()) {
+            id_type current = id_type(ws.open.pop());
+            stats.expanded(current, ws.open.size());
             
-            for (node* neighbour : current->neighbours) {
-                float tentative_gscore = gscore[current] + d.cost(current, neighbour);
+            if (current == to) {
+                stats.allocated(detail::workspace_growth(ws, workspace_size));
+                stats.end_phase(search_phase::search);
+                stats.begin_phase(search_phase::reconstruct);
                 
+                auto path = ws.path_to(current);
                 
-                if (tentative_gscore < gscore[neighbour]) {
-                    came_from[neighbour] = current;
-                    gscore[neighbour] = tentative_gscore;
+                stats.allocated(path.capacity() * sizeof(id_type));
+                stats.end_phase(search_phase::reconstruct);
+                stats.end_query(true);
+                
+                return path;
+            }
+            
+            const float current_gscore = ws.gscore(current);
+            
+            
+            auto neighbours = g.neighbours(current);
+            auto costs      = g.costs(current);
+            
+            for (std::size_t i = 0; i < neighbours.size(); ++i) {
+                id_type neighbour = neighbours[i];
+                float tentative_gscore = current_gscore + costs[i];
+                
+                stats.relaxed();
+                
+                
+                if (tentative_gscore < ws.gscore(neighbour)) {
+                    if (ws.visited(neighbour)) stats.decreased_key();
                     
-                    discovered.erase(neighbour);
-                    fscore[neighbour] = tentative_gscore + h.cost(neighbour, to);
-                    discovered.insert(neighbour);
+                    ws.visit(neighbour, tentative_gscore, current);
+                    ws.open.push_or_update(neighbour, tentative_gscore + h(g.position(neighbour), target));
+                    
+                    stats.heuristic_evaluated();
+                    stats.pushed(ws.open.size());
                 }
             }
         }
         
         
+        stats.allocated(detail::workspace_growth(ws, workspace_size));
+        stats.end_phase(search_phase::search);
+        stats.end_query(false);
+        
         return {};
     }
+    
+    
+    template <CsrGraph G, typename Heuristic>
+    inline std::vector<csr_graph::id_type> A_star(const G& g, csr_graph::id_type from, csr_graph::id_type to, Heuristic&& h) {
+        search_workspace ws;
+        return A_star(g, from, to, h, ws);
+    }
+    
+    
+    template <CsrGraph G>
+    inline std::vector<csr_graph::id_type> A_star(const G& g, csr_graph::id_type from, csr_graph::id_type to) {
+        return A_star(g, from, to, euclidean_cost {});
+    }
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/A_star.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/search_workspace.hpp>
+#include <imperative/thread_pool.hpp>
+
+#include <vector>
+#include <span>
+#include <stdexcept>
+#include <cstddef>
+
+
+namespace imp {
+    struct path_query {
+        node* from;
+        node* to;
+    };
+    
+    
+    // Answers every query in queries with A_star, spread across the workers of pool, and stores the path for queries[i] in results[i].
+    // Edge costs are read from the graph. g is only read, so it may be shared with other batches or searches running at the same time,
+    // but it must not be modified until the batch has finished. h is shared by all workers, so its cost function must be safe to call concurrently.
+    //
+    // Every worker thread keeps its own workspace between batches, so repeated batches don't allocate any per-node state.
+    template <typename OpenSet = heap_open_set, CostPolicy H>
+    inline void A_star_batch(const graph& g, std::span<const path_query> queries, std::span<std::vector<node*>> results, H&& h, thread_pool& pool) {
+        if (results.size() < queries.size()) throw std::invalid_argument { "A_star_batch: results must have room for every query." };
+        
+        
+        // Queries can differ a lot in cost, so use several chunks per worker and let the workers steal the remainder.
+        const std::size_t chunk = std::max<std::size_t>(queries.size() / (std::size_t(pool.size()) * 8), 1);
+        
+        pool.parallel_for(queries.size(), chunk, [&](std::size_t begin, std::size_t end, unsigned worker) {
+            thread_local basic_search_workspace<OpenSet> ws;
+            
+            for (std::size_t i = begin; i < end; ++i) {
+                results[i] = A_star(g, queries[i].from, queries[i].to, h, ws);
+            }
+        });
+    }
+}
\ No newline at end of file
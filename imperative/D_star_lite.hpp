@@ -0,0 +1,182 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/container/indexed_heap.hpp>
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+
+namespace imp {
+    // Incremental planner using D* Lite (Koenig & Likhachev). The search runs backwards from the goal,
+    // and its state is kept between calls to plan(), so after edge costs change or the start moves,
+    // only the part of the search tree that is affected by the change is repaired.
+    //
+    // Edge costs are read from the graph. After changing the cost of an edge (e.g. through graph::set_edge_cost),
+    // call edge_cost_changed with both of its nodes. Nodes must not be added to the graph while the planner is in use.
+    // The heuristic must be consistent for the current edge costs; euclidean_cost is, as long as no edge is cheaper than its length.
+    template <CostPolicy Heuristic = euclidean_cost>
+    class D_star_lite {
+    public:
+        D_star_lite(const graph& g, node* start, node* goal, Heuristic h = Heuristic {}) :
+            g(&g),
+            start(start),
+            goal(goal),
+            last_start(start),
+            h(std::move(h)),
+            gscore(g.nodes.size(), infinity),
+            rhs(g.nodes.size(), infinity),
+            open(g.nodes.size())
+        {
+            rhs[goal->id] = 0;
+            open.push(goal->id, calculate_key(goal->id));
+        }
+        
+        
+        // Repairs the search and returns the current shortest path from the start to the goal, or an empty path if there is none.
+        std::vector<node*> plan(void) {
+            compute_shortest_path();
+            if (gscore[start->id] == infinity) return {};
+            
+            
+            // Follow the cheapest neighbour towards the goal. The number of steps is bounded to guard against cycles of zero-cost edges.
+            std::vector<node*> result { start };
+            
+            for (node* current = start; current != goal && result.size() <= g->nodes.size(); ) {
+                node* best = nullptr;
+                float best_cost = infinity;
+                
+                for (std::size_t i = 0; i < current->neighbours.size(); ++i) {
+                    float cost = current->costs[i] + gscore[current->neighbours[i]->id];
+                    
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best = current->neighbours[i];
+                    }
+                }
+                
+                if (!best) return {};
+                
+                result.push_back(best);
+                current = best;
+            }
+            
+            return result.back() == goal ? result : std::vector<node*> {};
+        }
+        
+        
+        // Moves the start of the search, e.g. when the unit has moved along the path.
+        void move_start(node* new_start) {
+            // Keys already in the open list were computed relative to the old start. Rather than updating every key,
+            // new keys are offset by the distance the start has moved, which keeps the keys in the open list valid lower bounds.
+            key_offset += h.cost(last_start, new_start);
+            last_start = new_start;
+            start = new_start;
+        }
+        
+        
+        // Must be called after the cost of the edge between a and b has changed.
+        void edge_cost_changed(const node& a, const node& b) {
+            update_vertex(a.id);
+            update_vertex(b.id);
+        }
+        
+        
+        node* get_start(void) const { return start; }
+        node* get_goal(void) const { return goal; }
+        
+        // Cost of the shortest path from n to the goal, as of the last call to plan(). Infinite if it is unknown or there is none.
+        float cost_to_goal(const node& n) const { return gscore[n.id]; }
+    private:
+        using key_type = std::pair<float, float>;
+        constexpr static float infinity = std::numeric_limits<float>::infinity();
+        constexpr static float key_tolerance = 1e-5f;
+        
+        const graph* g;
+        node* start;
+        node* goal;
+        node* last_start;
+        
+        Heuristic h;
+        float key_offset = 0;
+        
+        // gscore is the cost to the goal as of the last expansion, rhs is the one-step lookahead based on the neighbours' gscore.
+        // A node is consistent if both are equal, and only inconsistent nodes are in the open list.
+        std::vector<float> gscore, rhs;
+        indexed_heap<key_type, 4> open;
+        
+        
+        key_type calculate_key(std::size_t n) {
+            const float best = std::min(gscore[n], rhs[n]);
+            return { best + h.cost(start, g->nodes[n].get()) + key_offset, best };
+        }
+        
+        
+        // Keys are sums of floats that are rounded differently depending on the order they were added in, so keys that are equal
+        // in exact arithmetic can differ in their last bits. On grids many keys are tied, and comparing them exactly would stop
+        // compute_shortest_path just before a change reaches the start. Keys whose first components are within key_tolerance
+        // of each other are therefore treated as equal. The second component is ignored, since it only breaks exact ties.
+        static bool key_less(const key_type& a, const key_type& b) {
+            if (!std::isfinite(a.first) || !std::isfinite(b.first)) return a.first < b.first;
+            return a.first < b.first - key_tolerance * std::max({ std::abs(a.first), std::abs(b.first), 1.0f });
+        }
+        
+        
+        void update_vertex(std::size_t n) {
+            if (n != goal->id) {
+                const node* current = g->nodes[n].get();
+                float best = infinity;
+                
+                for (std::size_t i = 0; i < current->neighbours.size(); ++i) {
+                    best = std::min(best, current->costs[i] + gscore[current->neighbours[i]->id]);
+                }
+                
+                rhs[n] = best;
+            }
+            
+            
+            if (gscore[n] != rhs[n]) open.push_or_update(n, calculate_key(n));
+            else if (open.contains(n)) open.erase(n);
+        }
+        
+        
+        void compute_shortest_path(void) {
+            const std::size_t s = start->id;
+            
+            // Nodes with a key tied with that of the start are expanded as well, since they may still lower or raise its cost.
+            while (!open.empty() && (!key_less(calculate_key(s), open.top().key) || rhs[s] != gscore[s])) {
+                const std::size_t u = open.top().index;
+                const key_type old_key = open.top().key;
+                const key_type new_key = calculate_key(u);
+                
+                
+                if (key_less(old_key, new_key)) {
+                    // The key was computed before the start moved.
+                    open.update(u, new_key);
+                    continue;
+                }
+                
+                open.pop();
+                const node* current = g->nodes[u].get();
+                
+                
+                if (gscore[u] > rhs[u]) {
+                    // Overconsistent: the node got cheaper, so its new cost is final and can be propagated.
+                    gscore[u] = rhs[u];
+                    for (const node* neighbour : current->neighbours) update_vertex(neighbour->id);
+                } else {
+                    // Underconsistent: the node got more expensive. Invalidate it, and let it and its neighbours find new costs.
+                    gscore[u] = infinity;
+                    
+                    update_vertex(u);
+                    for (const node* neighbour : current->neighbours) update_vertex(neighbour->id);
+                }
+            }
+        }
+    };
+}
\ No newline at end of file
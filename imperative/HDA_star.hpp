@@ -0,0 +1,276 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/cost_function.hpp>
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    namespace detail {
+        // Lock-free multiple producer, single consumer queue of batches.
+        // Producers push onto a linked stack, and the consumer takes the whole stack at once,
+        // so there are no concurrent pops and no ABA problem.
+        template <typename T>
+        class mpsc_batch_queue {
+        public:
+            struct batch {
+                std::vector<T> items;
+                batch* next = nullptr;
+            };
+            
+            
+            mpsc_batch_queue(void) = default;
+            mpsc_batch_queue(const mpsc_batch_queue&) = delete;
+            mpsc_batch_queue& operator=(const mpsc_batch_queue&) = delete;
+            
+            ~mpsc_batch_queue(void) {
+                delete_all(take_all());
+            }
+            
+            
+            void push(std::unique_ptr<batch> b) {
+                batch* node = b.release();
+                node->next = head.load(std::memory_order_relaxed);
+                
+                while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+            }
+            
+            
+            // Returns every batch in the queue as a linked list, most recent first, or nullptr if the queue is empty.
+            // The caller takes ownership of the batches.
+            batch* take_all(void) {
+                if (!head.load(std::memory_order_relaxed)) return nullptr;
+                return head.exchange(nullptr, std::memory_order_acquire);
+            }
+            
+            
+            static void delete_all(batch* b) {
+                while (b) delete std::exchange(b, b->next);
+            }
+        private:
+            std::atomic<batch*> head = nullptr;
+        };
+        
+        
+        // Shared implementation of the HDA_star overloads. edge_cost is invoked with a node and the index of one of its neighbours.
+        template <typename Heuristic, typename EdgeCost>
+        inline std::vector<node*> HDA_star_impl(const graph& g, node* from, node* to, Heuristic& h, EdgeCost&& edge_cost, unsigned threads) {
+            constexpr std::uint32_t no_parent = std::numeric_limits<std::uint32_t>::max();
+            constexpr float infinity = std::numeric_limits<float>::infinity();
+            
+            // Messages are buffered per destination, and sent once the buffer reaches this size
+            // or after every round of expansions, whichever comes first.
+            constexpr std::size_t batch_size = 64;
+            // Number of nodes a thread expands between checks of its incoming queue.
+            constexpr std::size_t expansions_per_poll = 16;
+            
+            
+            if (from == to) return { from };
+            threads = std::max(threads, 1u);
+            
+            
+            struct message {
+                std::uint32_t id;
+                std::uint32_t parent;
+                float gscore;
+            };
+            
+            struct open_entry {
+                float fscore, gscore;
+                std::uint32_t id;
+                
+                // Inverted for the max-heap std::priority_queue. Ties prefer the deeper node.
+                bool operator<(const open_entry& o) const {
+                    return fscore != o.fscore ? fscore > o.fscore : gscore < o.gscore;
+                }
+            };
+            
+            using queue_type = mpsc_batch_queue<message>;
+            
+            struct worker_state {
+                queue_type inbox;
+                std::priority_queue<open_entry> open;
+                std::vector<std::unique_ptr<typename queue_type::batch>> outgoing;
+            };
+            
+            
+            // Every node is owned by one thread, which is the only thread that reads or writes its gscore and parent.
+            std::vector<float> gscore(g.nodes.size(), infinity);
+            std::vector<std::uint32_t> parent(g.nodes.size(), no_parent);
+            
+            auto owner = [&](std::size_t id) {
+                return unsigned(((std::uint64_t(id) * 0x9E3779B97F4A7C15ull) >> 32) % threads);
+            };
+            
+            
+            // Cost of the best path to the goal found so far. Only the owner of the goal writes it.
+            std::atomic<float> incumbent = infinity;
+            
+            // Number of active threads plus the number of messages that have been sent but not processed.
+            // Threads only become active by receiving messages, so once this reaches zero the search is finished.
+            std::atomic<std::size_t> work = threads;
+            
+            
+            std::vector<worker_state> workers(threads);
+            for (auto& w : workers) w.outgoing.resize(threads);
+            
+            gscore[from->id] = 0;
+            workers[owner(from->id)].open.push(open_entry { h.cost(from, to), 0, std::uint32_t(from->id) });
+            
+            
+            auto run = [&](unsigned self) {
+                worker_state& state = workers[self];
+                bool active = true;
+                
+                
+                auto relax = [&](std::uint32_t id, float tentative_gscore, std::uint32_t came_from) {
+                    if (tentative_gscore >= gscore[id]) return;
+                    
+                    gscore[id] = tentative_gscore;
+                    parent[id] = came_from;
+                    
+                    // The goal is never expanded, reaching it only tightens the bound on the remaining search.
+                    if (id == to->id) {
+                        incumbent.store(std::min(incumbent.load(std::memory_order_relaxed), tentative_gscore), std::memory_order_relaxed);
+                        return;
+                    }
+                    
+                    float fscore = tentative_gscore + h.cost(g.nodes[id].get(), to);
+                    if (fscore < incumbent.load(std::memory_order_relaxed)) state.open.push(open_entry { fscore, tentative_gscore, id });
+                };
+                
+                
+                auto flush = [&](unsigned destination) {
+                    auto& b = state.outgoing[destination];
+                    if (!b || b->items.empty()) return;
+                    
+                    work.fetch_add(b->items.size(), std::memory_order_relaxed);
+                    workers[destination].inbox.push(std::move(b));
+                };
+                
+                auto send = [&](unsigned destination, message m) {
+                    auto& b = state.outgoing[destination];
+                    if (!b) b = std::make_unique<typename queue_type::batch>();
+                    
+                    b->items.push_back(m);
+                    if (b->items.size() >= batch_size) flush(destination);
+                };
+                
+                
+                while (true) {
+                    if (auto* received = state.inbox.take_all()) {
+                        // Become active before the messages stop counting as work, so the counter can't briefly reach zero.
+                        if (!active) {
+                            work.fetch_add(1, std::memory_order_relaxed);
+                            active = true;
+                        }
+                        
+                        std::size_t count = 0;
+                        
+                        for (auto* b = received; b; b = b->next) {
+                            for (const auto& m : b->items) relax(m.id, m.gscore, m.parent);
+                            count += b->items.size();
+                        }
+                        
+                        queue_type::delete_all(received);
+                        work.fetch_sub(count, std::memory_order_acq_rel);
+                    }
+                    
+                    
+                    for (std::size_t i = 0; i < expansions_per_poll && !state.open.empty(); ++i) {
+                        open_entry current = state.open.top();
+                        
+                        // Nodes that can't lead to a better path than the incumbent are pruned, and since the open list is ordered,
+                        // so is everything after them.
+                        if (current.fscore >= incumbent.load(std::memory_order_relaxed)) {
+                            state.open = {};
+                            break;
+                        }
+                        
+                        state.open.pop();
+                        
+                        // Stale entry: the node was reached again with a lower gscore after this entry was pushed.
+                        if (current.gscore > gscore[current.id]) continue;
+                        
+                        
+                        node* n = g.nodes[current.id].get();
+                        
+                        for (std::size_t j = 0; j < n->neighbours.size(); ++j) {
+                            const std::uint32_t neighbour = std::uint32_t(n->neighbours[j]->id);
+                            const float tentative_gscore = current.gscore + edge_cost(n, j);
+                            
+                            if (tentative_gscore >= incumbent.load(std::memory_order_relaxed)) continue;
+                            
+                            if (unsigned destination = owner(neighbour); destination == self) relax(neighbour, tentative_gscore, current.id);
+                            else send(destination, message { neighbour, current.id, tentative_gscore });
+                        }
+                    }
+                    
+                    
+                    // Other threads may be waiting for these nodes, so don't hold on to them until the batches are full.
+                    for (unsigned destination = 0; destination < threads; ++destination) flush(destination);
+                    
+                    
+                    if (state.open.empty()) {
+                        
+                        if (active) {
+                            work.fetch_sub(1, std::memory_order_acq_rel);
+                            active = false;
+                        }
+                        
+                        if (work.load(std::memory_order_acquire) == 0) return;
+                        std::this_thread::yield();
+                    }
+                }
+            };
+            
+            
+            {
+                std::vector<std::jthread> pool;
+                for (unsigned i = 1; i < threads; ++i) pool.emplace_back(run, i);
+                
+                run(0);
+            }
+            
+            
+            if (parent[to->id] == no_parent) return {};
+            
+            std::vector<node*> result { to };
+            for (std::uint32_t id = parent[to->id]; id != no_parent; id = parent[id]) result.push_back(g.nodes[id].get());
+            
+            std::reverse(result.begin(), result.end());
+            return result;
+        }
+    }
+    
+    
+    // Hash-distributed A* (HDA*): a single query searched by several threads at once.
+    // Every node is assigned to a thread by a hash of its ID. Each thread expands the nodes it owns from its own open list,
+    // and sends newly reached nodes to their owner through a lock-free queue. The search stops once no thread has a node
+    // that could improve on the best path found so far and no messages are pending, so the result is still optimal
+    // as long as h is admissible. Every thread touches nodes all over the graph, so this only pays off for long queries.
+    //
+    // The calling thread takes part in the search, and threads - 1 additional threads are started for the duration of the query.
+    // h and d are shared by all threads, so their cost functions must be safe to call concurrently.
+    template <CostPolicy H, CostPolicy D>
+    inline std::vector<node*> HDA_star(const graph& g, node* from, node* to, H&& h, D&& d, unsigned threads = std::thread::hardware_concurrency()) {
+        return detail::HDA_star_impl(g, from, to, h, [&](node* current, std::size_t i) { return d.cost(current, current->neighbours[i]); }, threads);
+    }
+    
+    
+    // Uses the edge costs stored in the graph.
+    template <CostPolicy H>
+    inline std::vector<node*> HDA_star(const graph& g, node* from, node* to, H&& h, unsigned threads = std::thread::hardware_concurrency()) {
+        return detail::HDA_star_impl(g, from, to, h, [](node* current, std::size_t i) { return current->costs[i]; }, threads);
+    }
+}
\ No newline at end of file
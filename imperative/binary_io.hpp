@@ -0,0 +1,63 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace imp::binary_io {
+    // Helpers for the binary file formats used by precomputed search data.
+    // All values are written in native endianness and layout, so files are only portable between similar machines.
+    
+    
+    template <typename T> inline void write(std::ostream& stream, const T* data, std::size_t count) {
+        stream.write(reinterpret_cast<const char*>(data), std::streamsize(count * sizeof(T)));
+    }
+    
+    template <typename T> inline void write(std::ostream& stream, const T& value) {
+        write(stream, &value, 1);
+    }
+    
+    template <typename T> inline void write(std::ostream& stream, const std::vector<T>& values) {
+        write(stream, std::uint64_t(values.size()));
+        write(stream, values.data(), values.size());
+    }
+    
+    
+    template <typename T> inline void read(std::istream& stream, T* data, std::size_t count) {
+        stream.read(reinterpret_cast<char*>(data), std::streamsize(count * sizeof(T)));
+    }
+    
+    template <typename T> inline T read(std::istream& stream) {
+        T value {};
+        read(stream, &value, 1);
+        return value;
+    }
+    
+    template <typename T> inline void read(std::istream& stream, std::vector<T>& values) {
+        values.resize(std::size_t(read<std::uint64_t>(stream)));
+        read(stream, values.data(), values.size());
+    }
+    
+    
+    // Writes the magic bytes and format version that start every file.
+    inline void write_header(std::ostream& stream, const char (&magic)[8], std::uint32_t version) {
+        stream.write(magic, sizeof(magic));
+        write(stream, version);
+    }
+    
+    
+    // Checks the magic bytes and format version, throwing a std::runtime_error if they don't match.
+    inline void read_header(std::istream& stream, const char (&magic)[8], std::uint32_t version, const std::string& path) {
+        char found[sizeof(magic)];
+        stream.read(found, sizeof(found));
+        
+        if (!stream || std::memcmp(found, magic, sizeof(magic)) != 0) throw std::runtime_error { "Unrecognized file format: " + path };
+        if (read<std::uint32_t>(stream) != version) throw std::runtime_error { "Unsupported file version: " + path };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <algorithm>
+
+
+namespace imp {
+    // D-ary min-heap over dense indices [0, N) with the key of each element stored inline.
+    // The position of each index in the heap is tracked, so keys can be changed in O(log N) without searching.
+    //
+    // Positions are never reset: an index is only considered present if its stored position points back at it.
+    // This means clear() is O(size) rather than O(N) and the heap can be reused between searches.
+    template <typename Key, std::size_t Arity = 4, typename Compare = std::less<Key>>
+    class indexed_heap {
+    public:
+        static_assert(Arity >= 2, "A heap must have at least two children per element.");
+        
+        
+        struct entry {
+            std::size_t index;
+            Key key;
+        };
+        
+        
+        explicit indexed_heap(std::size_t indices = 0, Compare comparator = Compare {}) :
+            positions(indices),
+            comparator(std::move(comparator))
+        {}
+        
+        
+        // Makes sure indices up to (but not including) count can be stored in the heap.
+        void reserve_indices(std::size_t count) {
+            if (positions.size() < count) positions.resize(count);
+        }
+        
+        
+        bool empty(void) const { return elements.empty(); }
+        std::size_t size(void) const { return elements.size(); }
+        void clear(void) { elements.clear(); }
+        
+        
+        bool contains(std::size_t index) const {
+            return index < positions.size()          &&
+                   positions[index] < elements.size() &&
+                   elements[positions[index]].index == index;
+        }
+        
+        const Key& key(std::size_t index) const {
+            return elements[positions[index]].key;
+        }
+        
+        const entry& top(void) const {
+            return elements.front();
+        }
+        
+        // Approximate memory used by the heap in bytes.
+        std::size_t memory_usage(void) const {
+            return elements.capacity() * sizeof(entry) + positions.capacity() * sizeof(std::size_t);
+        }
+        
+        // All elements, in heap order.
+        std::span<const entry> entries(void) const {
+            return elements;
+        }
+        
+        
+        void push(std::size_t index, Key key) {
+            reserve_indices(index + 1);
+            
+            elements.push_back(entry { index, std::move(key) });
+            sift_up(elements.size() - 1);
+        }
+        
+        
+        std::size_t pop(void) {
+            std::size_t result = elements.front().index;
+            remove_at(0);
+            return result;
+        }
+        
+        
+        // Precondition: key does not compare greater than the current key of index.
+        void decrease_key(std::size_t index, Key key) {
+            std::size_t pos = positions[index];
+            elements[pos].key = std::move(key);
+            sift_up(pos);
+        }
+        
+        
+        // Changes the key of index in either direction.
+        void update(std::size_t index, Key key) {
+            std::size_t pos = positions[index];
+            
+            if (comparator(key, elements[pos].key)) {
+                elements[pos].key = std::move(key);
+                sift_up(pos);
+            } else {
+                elements[pos].key = std::move(key);
+                sift_down(pos);
+            }
+        }
+        
+        
+        // Inserts index if it is not present, otherwise changes its key.
+        void push_or_update(std::size_t index, Key key) {
+            if (contains(index)) update(index, std::move(key));
+            else push(index, std::move(key));
+        }
+        
+        
+        void erase(std::size_t index) {
+            remove_at(positions[index]);
+        }
+    private:
+        std::vector<entry> elements;
+        std::vector<std::size_t> positions;
+        [[no_unique_address]] Compare comparator;
+        
+        
+        void place(std::size_t pos, entry&& e) {
+            positions[e.index] = pos;
+            elements[pos] = std::move(e);
+        }
+        
+        
+        void sift_up(std::size_t pos) {
+            entry moving = std::move(elements[pos]);
+            
+            while (pos > 0) {
+                std::size_t parent = (pos - 1) / Arity;
+                if (!comparator(moving.key, elements[parent].key)) break;
+                
+                place(pos, std::move(elements[parent]));
+                pos = parent;
+            }
+            
+            place(pos, std::move(moving));
+        }
+        
+        
+        void sift_down(std::size_t pos) {
+            entry moving = std::move(elements[pos]);
+            const std::size_t count = elements.size();
+            
+            while (true) {
+                std::size_t first = pos * Arity + 1;
+                if (first >= count) break;
+                
+                // Find the smallest of the (up to) Arity children.
+                std::size_t last = std::min(first + Arity, count);
+                std::size_t best = first;
+                
+                for (std::size_t child = first + 1; child < last; ++child) {
+                    if (comparator(elements[child].key, elements[best].key)) best = child;
+                }
+                
+                if (!comparator(elements[best].key, moving.key)) break;
+                
+                place(pos, std::move(elements[best]));
+                pos = best;
+            }
+            
+            place(pos, std::move(moving));
+        }
+        
+        
+        void remove_at(std::size_t pos) {
+            // Move the last element into the gap, then restore the heap property in whichever direction is required.
+            entry last = std::move(elements.back());
+            elements.pop_back();
+            
+            if (pos == elements.size()) return;
+            
+            bool moves_up = pos > 0 && comparator(last.key, elements[(pos - 1) / Arity].key);
+            place(pos, std::move(last));
+            
+            if (moves_up) sift_up(pos);
+            else sift_down(pos);
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Table of interned strings. Every distinct string is stored once, in a single shared character buffer,
+    // and identified by a dense ID in the order it was first added.
+    // Lookups by content use an open addressing hash table of IDs, so the overhead per string is a few words
+    // rather than a separate allocation and a hash map node.
+    class string_table {
+    public:
+        using id_type = std::uint32_t;
+        constexpr static id_type invalid_id = std::numeric_limits<id_type>::max();
+        
+        
+        // Returns the ID of s, adding it to the table if it isn't present yet.
+        id_type intern(std::string_view s) {
+            if (2 * (size() + 1) > slots.size()) grow();
+            
+            std::size_t slot = find_slot(s);
+            if (slots[slot] != invalid_id) return slots[slot];
+            
+            
+            const id_type id = id_type(size());
+            
+            chars.append(s);
+            offsets.push_back(chars.size());
+            slots[slot] = id;
+            
+            return id;
+        }
+        
+        
+        // Returns the ID of s, or invalid_id if it isn't in the table.
+        id_type find(std::string_view s) const {
+            if (slots.empty()) return invalid_id;
+            return slots[find_slot(s)];
+        }
+        
+        
+        std::string_view get(id_type id) const {
+            return std::string_view { chars }.substr(offsets[id], offsets[id + 1] - offsets[id]);
+        }
+        
+        
+        std::size_t size(void) const { return offsets.size() - 1; }
+        
+        
+        // Approximate memory used by the table in bytes.
+        std::size_t memory_usage(void) const {
+            return chars.capacity() + offsets.capacity() * sizeof(std::uint64_t) + slots.capacity() * sizeof(id_type);
+        }
+    private:
+        std::string chars;
+        std::vector<std::uint64_t> offsets { 0 };
+        
+        // The hash table is kept at most half full. Its size is a power of two.
+        std::vector<id_type> slots;
+        
+        
+        // FNV-1a.
+        static std::uint64_t hash(std::string_view s) {
+            std::uint64_t result = 0xCBF29CE484222325ull;
+            
+            for (char c : s) {
+                result ^= std::uint8_t(c);
+                result *= 0x100000001B3ull;
+            }
+            
+            return result;
+        }
+        
+        
+        // Returns the slot containing s, or the empty slot where it would be inserted.
+        std::size_t find_slot(std::string_view s) const {
+            const std::size_t mask = slots.size() - 1;
+            
+            for (std::size_t slot = hash(s) & mask; ; slot = (slot + 1) & mask) {
+                if (slots[slot] == invalid_id || get(slots[slot]) == s) return slot;
+            }
+        }
+        
+        
+        void grow(void) {
+            slots.assign(std::max<std::size_t>(slots.size() * 2, 16), invalid_id);
+            
+            for (id_type id = 0; id < size(); ++id) slots[find_slot(get(id))] = id;
+        }
+    };
+}
\ No newline at end of file
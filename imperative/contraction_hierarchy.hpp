@@ -0,0 +1,456 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/search_workspace.hpp>
+#include <imperative/binary_io.hpp>
+#include <imperative/container/indexed_heap.hpp>
+
+#include <vector>
+#include <span>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+
+namespace imp {
+    // Contraction hierarchy over the stored edge costs of a graph.
+    // Nodes are contracted one at a time in order of increasing importance, adding shortcut edges wherever a shortest
+    // path went through the contracted node. Queries then only need to follow edges towards more important nodes,
+    // from both ends, which visits a tiny part of the graph compared to A*.
+    //
+    // Since graph edges are undirected with symmetric costs, every edge is only stored once, at its least important endpoint.
+    class contraction_hierarchy {
+    public:
+        using id_type = std::uint32_t;
+        constexpr static id_type no_middle = std::numeric_limits<id_type>::max();
+        
+        
+        struct edge {
+            id_type target;
+            float cost;
+            // For shortcuts, the node that was contracted to create this edge. no_middle for edges of the original graph.
+            id_type middle;
+        };
+        
+        
+        struct build_settings {
+            // Maximum number of nodes a witness search settles before giving up (and adding the shortcut).
+            std::size_t witness_settle_limit = 500;
+            // The same limit, used when estimating the number of shortcuts to order the nodes.
+            // Overestimating only affects the contraction order, so a much lower limit can be used here.
+            std::size_t priority_settle_limit = 50;
+        };
+        
+        
+        contraction_hierarchy(void) = default;
+        
+        
+        static contraction_hierarchy build(const graph& g, build_settings settings) {
+            builder b { g, settings };
+            return b.run();
+        }
+        
+        static contraction_hierarchy build(const graph& g) {
+            return build(g, build_settings {});
+        }
+        
+        
+        std::size_t node_count(void) const { return rank.size(); }
+        std::size_t edge_count(void) const { return edges.size(); }
+        
+        
+        // Returns the shortest path between the nodes with the given IDs, or an empty path if there is none.
+        // The path is fully unpacked, i.e. it only contains edges of the original graph.
+        template <typename OpenSet>
+        std::vector<id_type> query(id_type from, id_type to, basic_search_workspace<OpenSet>& forward, basic_search_workspace<OpenSet>& backward) const {
+            using ws_type = basic_search_workspace<OpenSet>;
+            
+            
+            if (from == to) return { from };
+            
+            forward.begin_query(node_count());
+            forward.visit(from, 0, ws_type::no_parent);
+            forward.open.push_or_update(from, 0);
+            
+            backward.begin_query(node_count());
+            backward.visit(to, 0, ws_type::no_parent);
+            backward.open.push_or_update(to, 0);
+            
+            
+            float best_length = std::numeric_limits<float>::infinity();
+            id_type meeting_point = no_middle;
+            
+            auto expand = [&](ws_type& self, const ws_type& other) {
+                const id_type current = id_type(self.open.pop());
+                const float current_gscore = self.gscore(current);
+                
+                if (other.visited(current) && current_gscore + other.gscore(current) < best_length) {
+                    best_length   = current_gscore + other.gscore(current);
+                    meeting_point = current;
+                }
+                
+                
+                // Stall-on-demand: if a more important neighbour offers a shorter path to this node,
+                // this node cannot be on a shortest path from the source, so its edges don't need to be relaxed.
+                for (const edge& e : upward(current)) {
+                    if (self.gscore(e.target) + e.cost < current_gscore) return;
+                }
+                
+                
+                for (const edge& e : upward(current)) {
+                    float tentative_gscore = current_gscore + e.cost;
+                    
+                    if (tentative_gscore < self.gscore(e.target)) {
+                        self.visit(e.target, tentative_gscore, current);
+                        self.open.push_or_update(e.target, tentative_gscore);
+                    }
+                }
+            };
+            
+            
+            // Each search can stop once its lowest key exceeds the best path found so far.
+            while (true) {
+                const bool forward_done  = forward.open.empty()  || forward.open.min_score()  >= best_length;
+                const bool backward_done = backward.open.empty() || backward.open.min_score() >= best_length;
+                
+                if (forward_done && backward_done) break;
+                
+                if (backward_done || (!forward_done && forward.open.min_score() <= backward.open.min_score())) expand(forward, backward);
+                else expand(backward, forward);
+            }
+            
+            
+            if (meeting_point == no_middle) return {};
+            
+            
+            // Path from the source to the meeting point and from there to the target, still containing shortcuts.
+            std::vector<id_type> packed;
+            for (auto id : forward.path_to(meeting_point)) packed.push_back(id);
+            for (auto id = backward.came_from(meeting_point); id != ws_type::no_parent; id = backward.came_from(id)) packed.push_back(id);
+            
+            std::vector<id_type> result { packed.front() };
+            for (std::size_t i = 1; i < packed.size(); ++i) unpack(packed[i - 1], packed[i], result);
+            
+            return result;
+        }
+        
+        
+        template <typename OpenSet>
+        std::vector<node*> query(const graph& g, node* from, node* to, basic_search_workspace<OpenSet>& forward, basic_search_workspace<OpenSet>& backward) const {
+            std::vector<node*> result;
+            
+            for (auto id : query(id_type(from->id), id_type(to->id), forward, backward)) result.push_back(g.nodes[id].get());
+            return result;
+        }
+        
+        
+        std::vector<node*> query(const graph& g, node* from, node* to) const {
+            search_workspace forward, backward;
+            return query(g, from, to, forward, backward);
+        }
+        
+        
+        // Searches every node that can be reached from source through edges towards more important nodes,
+        // and invokes on_settled(id, distance) for each settled node that is not pruned by stall-on-demand.
+        // The highest ranked node of a shortest path is always reported with its exact distance from either end,
+        // so combining the search spaces of two nodes gives their distance (see many_to_many in distance_matrix.hpp).
+        template <typename OpenSet, typename F>
+        void upward_search(id_type source, basic_search_workspace<OpenSet>& ws, F&& on_settled) const {
+            using ws_type = basic_search_workspace<OpenSet>;
+            
+            
+            ws.begin_query(node_count());
+            ws.visit(source, 0, ws_type::no_parent);
+            ws.open.push_or_update(source, 0);
+            
+            while (!ws.open.empty()) {
+                const id_type current = id_type(ws.open.pop());
+                const float current_gscore = ws.gscore(current);
+                
+                const auto edges = upward(current);
+                
+                if (std::any_of(edges.begin(), edges.end(), [&](const edge& e) { return ws.gscore(e.target) + e.cost < current_gscore; })) continue;
+                on_settled(current, current_gscore);
+                
+                
+                for (const edge& e : edges) {
+                    float tentative_gscore = current_gscore + e.cost;
+                    
+                    if (tentative_gscore < ws.gscore(e.target)) {
+                        ws.visit(e.target, tentative_gscore, current);
+                        ws.open.push_or_update(e.target, tentative_gscore);
+                    }
+                }
+            }
+        }
+        
+        
+        // Edges from the given node to more important nodes.
+        std::span<const edge> upward(id_type id) const {
+            return { edges.data() + offsets[id], edges.data() + offsets[id + 1] };
+        }
+        
+        
+        // Position of the node in the contraction order. Nodes with a higher rank are more important.
+        id_type get_rank(id_type id) const {
+            return rank[id];
+        }
+        
+        
+        // Binary format (native endianness):
+        // char[8]              magic ("FP2CH" followed by three null bytes)
+        // uint32               format version
+        // uint64 + uint32[N]   rank of each node
+        // uint64 + uint64[N+1] offset of the upward edges of each node
+        // uint64 + edge[M]     upward edges
+        void save(const std::string& path) const {
+            std::ofstream stream { path, std::ios::binary };
+            if (!stream) throw std::runtime_error { "Failed to open contraction hierarchy file for writing: " + path };
+            
+            binary_io::write_header(stream, file_magic, file_version);
+            binary_io::write(stream, rank);
+            binary_io::write(stream, offsets);
+            binary_io::write(stream, edges);
+            
+            if (!stream) throw std::runtime_error { "Failed to write contraction hierarchy file: " + path };
+        }
+        
+        
+        static contraction_hierarchy load(const std::string& path) {
+            std::ifstream stream { path, std::ios::binary };
+            if (!stream) throw std::runtime_error { "Failed to open contraction hierarchy file: " + path };
+            
+            binary_io::read_header(stream, file_magic, file_version, path);
+            
+            contraction_hierarchy result;
+            binary_io::read(stream, result.rank);
+            binary_io::read(stream, result.offsets);
+            binary_io::read(stream, result.edges);
+            
+            if (!stream || result.offsets.size() != result.rank.size() + 1) {
+                throw std::runtime_error { "Contraction hierarchy file is truncated: " + path };
+            }
+            
+            return result;
+        }
+    private:
+        constexpr static char file_magic[8] = { 'F', 'P', '2', 'C', 'H', '\0', '\0', '\0' };
+        constexpr static std::uint32_t file_version = 1;
+        
+        std::vector<id_type> rank;
+        std::vector<std::uint64_t> offsets;
+        std::vector<edge> edges;
+        
+        
+        // Finds the edge between a and b, which is stored at whichever of the two is least important.
+        const edge& find_edge(id_type a, id_type b) const {
+            if (rank[a] > rank[b]) std::swap(a, b);
+            
+            auto candidates = upward(a);
+            return *std::find_if(candidates.begin(), candidates.end(), [&](const edge& e) { return e.target == b; });
+        }
+        
+        
+        // Appends the original edges making up the edge from a to b to path, excluding a itself.
+        void unpack(id_type a, id_type b, std::vector<id_type>& path) const {
+            const edge& e = find_edge(a, b);
+            
+            if (e.middle == no_middle) {
+                path.push_back(b);
+            } else {
+                unpack(a, e.middle, path);
+                unpack(e.middle, b, path);
+            }
+        }
+        
+        
+        class builder {
+        public:
+            builder(const graph& g, build_settings settings) :
+                settings(settings),
+                remaining(g.nodes.size()),
+                upward(g.nodes.size()),
+                contracted_neighbours(g.nodes.size(), 0),
+                witness_limit(g.nodes.size(), -1)
+            {
+                for (const auto& n : g.nodes) {
+                    for (std::size_t i = 0; i < n->neighbours.size(); ++i) {
+                        if (n->neighbours[i] == n.get()) continue;
+                        add_or_improve(remaining[n->id], edge { id_type(n->neighbours[i]->id), n->costs[i], no_middle });
+                    }
+                }
+            }
+            
+            
+            contraction_hierarchy run(void) {
+                const std::size_t count = remaining.size();
+                
+                // Nodes are contracted by increasing priority. Priorities change as neighbours are contracted,
+                // so they are updated lazily: a popped node is only contracted if its recomputed priority is still the lowest.
+                // Eagerly updating the neighbours of every contracted node as well is several times slower without
+                // producing a noticeably better order.
+                indexed_heap<long long, 4> queue { count };
+                for (id_type v = 0; v < count; ++v) queue.push(v, priority(v));
+                
+                
+                contraction_hierarchy result;
+                result.rank.resize(count);
+                id_type next_rank = 0;
+                
+                while (!queue.empty()) {
+                    const id_type v = id_type(queue.top().index);
+                    const long long updated = priority(v);
+                    
+                    queue.pop();
+                    
+                    if (!queue.empty() && updated > queue.top().key) {
+                        queue.push(v, updated);
+                        continue;
+                    }
+                    
+                    
+                    contract(v);
+                    result.rank[v] = next_rank++;
+                }
+                
+                
+                result.offsets.reserve(count + 1);
+                result.offsets.push_back(0);
+                
+                for (id_type v = 0; v < count; ++v) {
+                    result.edges.insert(result.edges.end(), upward[v].begin(), upward[v].end());
+                    result.offsets.push_back(result.edges.size());
+                }
+                
+                return result;
+            }
+        private:
+            build_settings settings;
+            
+            // Edges between nodes that have not been contracted yet.
+            std::vector<std::vector<edge>> remaining;
+            // Edges of contracted nodes, which all lead to nodes that were contracted later.
+            std::vector<std::vector<edge>> upward;
+            
+            std::vector<int> contracted_neighbours;
+            
+            search_workspace witness;
+            // Per node, the length a witness path must not exceed during the current witness search, or -1 for non-targets.
+            std::vector<float> witness_limit;
+            
+            
+            static void add_or_improve(std::vector<edge>& edges, edge e) {
+                auto it = std::find_if(edges.begin(), edges.end(), [&](const edge& existing) { return existing.target == e.target; });
+                
+                if (it == edges.end()) edges.push_back(e);
+                else if (e.cost < it->cost) *it = e;
+            }
+            
+            
+            // Edge difference plus the number of contracted neighbours, which keeps contraction spread evenly across the graph.
+            long long priority(id_type v) {
+                long long shortcuts = (long long) find_shortcuts(v, settings.priority_settle_limit, [](id_type, id_type, float) {});
+                return shortcuts - (long long) remaining[v].size() + contracted_neighbours[v];
+            }
+            
+            
+            // Invokes on_shortcut(u, w, cost) for every pair of neighbours of v whose shortest path goes through v.
+            // Returns the number of shortcuts found.
+            std::size_t find_shortcuts(id_type v, std::size_t settle_limit, auto&& on_shortcut) {
+                const auto& edges = remaining[v];
+                std::size_t found = 0;
+                
+                for (std::size_t i = 0; i + 1 < edges.size(); ++i) {
+                    // A shortcut from u = edges[i] to w = edges[j] is not needed if there is a path of at most this length that avoids v.
+                    float limit = 0;
+                    
+                    for (std::size_t j = i + 1; j < edges.size(); ++j) {
+                        witness_limit[edges[j].target] = edges[i].cost + edges[j].cost;
+                        limit = std::max(limit, witness_limit[edges[j].target]);
+                    }
+                    
+                    witness_search(edges[i].target, v, limit, edges.size() - i - 1, settle_limit);
+                    
+                    
+                    for (std::size_t j = i + 1; j < edges.size(); ++j) {
+                        float via = witness_limit[edges[j].target];
+                        witness_limit[edges[j].target] = -1;
+                        
+                        if (witness.gscore(edges[j].target) > via) {
+                            on_shortcut(edges[i].target, edges[j].target, via);
+                            ++found;
+                        }
+                    }
+                }
+                
+                return found;
+            }
+            
+            
+            // Dijkstra from source in the remaining graph, ignoring excluded and any node further away than limit.
+            // Stops after settle_limit nodes have been settled, or once each of the given number of targets
+            // (the nodes with a non-negative witness_limit) has been reached within its limit.
+            void witness_search(id_type source, id_type excluded, float limit, std::size_t targets, std::size_t settle_limit) {
+                witness.begin_query(remaining.size());
+                witness.visit(source, 0, search_workspace::no_parent);
+                witness.open.push_or_update(source, 0);
+                
+                for (std::size_t settled = 0; !witness.open.empty() && settled < settle_limit && targets > 0; ++settled) {
+                    const id_type current = id_type(witness.open.pop());
+                    const float current_gscore = witness.gscore(current);
+                    
+                    if (current_gscore > limit) break;
+                    
+                    
+                    for (const edge& e : remaining[current]) {
+                        if (e.target == excluded) continue;
+                        
+                        const float tentative_gscore = current_gscore + e.cost;
+                        const float previous_gscore  = witness.gscore(e.target);
+                        
+                        if (tentative_gscore < previous_gscore) {
+                            witness.visit(e.target, tentative_gscore, current);
+                            witness.open.push_or_update(e.target, tentative_gscore);
+                            
+                            // Count each target once, the first time a path within its limit is found.
+                            const float target_limit = witness_limit[e.target];
+                            if (tentative_gscore <= target_limit && previous_gscore > target_limit) --targets;
+                        }
+                    }
+                }
+            }
+            
+            
+            void contract(id_type v) {
+                std::vector<std::pair<id_type, id_type>> pairs;
+                std::vector<float> costs;
+                
+                find_shortcuts(v, settings.witness_settle_limit, [&](id_type u, id_type w, float cost) {
+                    pairs.emplace_back(u, w);
+                    costs.push_back(cost);
+                });
+                
+                for (std::size_t i = 0; i < pairs.size(); ++i) {
+                    auto [u, w] = pairs[i];
+                    
+                    add_or_improve(remaining[u], edge { w, costs[i], v });
+                    add_or_improve(remaining[w], edge { u, costs[i], v });
+                }
+                
+                
+                for (const edge& e : remaining[v]) {
+                    auto& neighbour_edges = remaining[e.target];
+                    std::erase_if(neighbour_edges, [&](const edge& n) { return n.target == v; });
+                    
+                    ++contracted_neighbours[e.target];
+                }
+                
+                upward[v] = std::move(remaining[v]);
+                remaining[v] = {};
+            }
+        };
+    };
+}
\ No newline at end of file
@@ -3,17 +3,107 @@
 #include <imperative/graph.hpp>
 #include <imperative/common.hpp>
 
+#include <concepts>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
 
 namespace imp {
+    // Any type with a cost(a, b) method can be used as a heuristic or traversal cost by the templated searches.
+    // Passing a concrete (or final) type allows the call to be inlined; cost_function is the virtual form of this interface.
+    template <typename F> concept CostPolicy = requires (F& f, const node* a, const node* b) {
+        { f.cost(a, b) } -> std::convertible_to<float>;
+    };
+    
+    
     struct cost_function {
         virtual ~cost_function(void) = default;
         virtual float cost(const node* a, const node* b) = 0;
     };
     
     
-    struct distance_based_cost : public cost_function {
+    // Wraps a CostPolicy so it can be passed to code that requires a cost_function.
+    template <CostPolicy F> struct virtual_cost : public cost_function {
+        F policy;
+        
+        explicit virtual_cost(F policy = F {}) : policy(std::move(policy)) {}
+        
+        float cost(const node* a, const node* b) override {
+            return policy.cost(a, b);
+        }
+    };
+    
+    
+    // Non-virtual cost policies. Each of these can also be invoked with two positions,
+    // so they can be used as a heuristic for csr_graph searches.
+    struct euclidean_cost {
+        float operator()(const vec2i& a, const vec2i& b) const {
+            return distance(a, b);
+        }
+        
+        float cost(const node* a, const node* b) const {
+            return (*this)(a->position, b->position);
+        }
+    };
+    
+    
+    // Admissible for graphs with only horizontal and vertical edges, like 4-connected grids.
+    struct manhattan_cost {
+        float operator()(const vec2i& a, const vec2i& b) const {
+            return float(std::abs(b.x - a.x) + std::abs(b.y - a.y));
+        }
+        
+        float cost(const node* a, const node* b) const {
+            return (*this)(a->position, b->position);
+        }
+    };
+    
+    
+    // Admissible for graphs with horizontal, vertical and diagonal edges, like 8-connected grids.
+    struct octile_cost {
+        float operator()(const vec2i& a, const vec2i& b) const {
+            const float dx = float(std::abs(b.x - a.x)), dy = float(std::abs(b.y - a.y));
+            return std::max(dx, dy) + (std::sqrt(2.0f) - 1.0f) * std::min(dx, dy);
+        }
+        
+        float cost(const node* a, const node* b) const {
+            return (*this)(a->position, b->position);
+        }
+    };
+    
+    
+    // Integer version of octile_cost, where straight steps cost 10 and diagonal steps 14.
+    // Baked into the edge costs of an 8-connected grid it is also a consistent heuristic for it,
+    // so every fscore is an integer and the grid can be searched exactly with the integer open sets in open_set.hpp.
+    struct integer_octile_cost {
+        float operator()(const vec2i& a, const vec2i& b) const {
+            const int dx = std::abs(b.x - a.x), dy = std::abs(b.y - a.y);
+            return float(10 * std::max(dx, dy) + 4 * std::min(dx, dy));
+        }
+        
+        float cost(const node* a, const node* b) const {
+            return (*this)(a->position, b->position);
+        }
+    };
+    
+    
+    // Final, so calls through a distance_based_cost& can be devirtualized and inlined.
+    struct distance_based_cost final : public cost_function {
         float cost(const node* a, const node* b) override {
             return distance(a->position, b->position);
         }
     };
+    
+    
+    template <typename D> inline void graph::bake_costs(D&& d) {
+        static_assert(CostPolicy<D>, "bake_costs requires a cost policy.");
+        ++version;
+        
+        for (auto& n : nodes) {
+            for (std::size_t i = 0; i < n->neighbours.size(); ++i) {
+                n->costs[i] = d.cost(n.get(), n->neighbours[i]);
+            }
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/common.hpp>
+#include <imperative/container/string_table.hpp>
+
+#include <vector>
+#include <span>
+#include <string_view>
+#include <concepts>
+#include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Immutable compressed sparse row representation of a graph.
+    // The neighbours of node i are targets[offsets[i]] to targets[offsets[i + 1]], with the cost of each edge
+    // at the same index in weights. Positions are stored as separate x and y arrays.
+    // Names are only needed for output, so they are kept out of the way in an interned string table,
+    // and each node only stores the ID of its name.
+    //
+    // Node IDs are the same as node::id in the graph this was created from,
+    // so g.nodes[id] can be used to map results back to the original nodes.
+    class csr_graph {
+    public:
+        using id_type = std::uint32_t;
+        constexpr static id_type invalid_id = ~id_type(0);
+        
+        
+        csr_graph(void) = default;
+        
+        
+        // Converts g, keeping the edge costs stored in the graph.
+        static csr_graph from_graph(const graph& g) {
+            return convert(g, [](const node* n, std::size_t i) { return n->costs[i]; });
+        }
+        
+        
+        // Converts g, storing the cost of each edge as given by d.
+        static csr_graph from_graph(const graph& g, cost_function& d) {
+            return convert(g, [&](const node* n, std::size_t i) { return d.cost(n, n->neighbours[i]); });
+        }
+        
+        
+        // Takes ownership of arrays that are already in CSR layout, as built by loaders that never create an imp::graph.
+        // Nodes created this way have no names.
+        static csr_graph from_arrays(std::vector<std::uint64_t> offsets, std::vector<id_type> targets, std::vector<float> weights, std::vector<int> xs, std::vector<int> ys) {
+            if (offsets.size() != xs.size() + 1 || ys.size() != xs.size() || weights.size() != targets.size() || offsets.back() != targets.size()) {
+                throw std::invalid_argument { "csr_graph::from_arrays: arrays have inconsistent sizes." };
+            }
+            
+            
+            csr_graph result;
+            
+            result.offsets = std::move(offsets);
+            result.targets = std::move(targets);
+            result.weights = std::move(weights);
+            result.xs      = std::move(xs);
+            result.ys      = std::move(ys);
+            
+            if (!result.xs.empty()) {
+                result.name_ids.assign(result.xs.size(), result.names.intern(""));
+                result.first_with_name.push_back(0);
+            }
+            
+            return result;
+        }
+        
+        
+        std::size_t node_count(void) const { return xs.size(); }
+        std::size_t edge_count(void) const { return targets.size(); }
+        
+        
+        std::span<const id_type> neighbours(id_type id) const {
+            return { targets.data() + offsets[id], targets.data() + offsets[id + 1] };
+        }
+        
+        std::span<const float> costs(id_type id) const {
+            return { weights.data() + offsets[id], weights.data() + offsets[id + 1] };
+        }
+        
+        vec2i position(id_type id) const {
+            return { xs[id], ys[id] };
+        }
+        
+        
+        std::string_view name(id_type id) const {
+            return names.get(name_ids[id]);
+        }
+        
+        
+        // Returns the node with the given name, or invalid_id if there is none.
+        // If several nodes share a name, the one with the lowest ID is returned.
+        id_type find_node(std::string_view name) const {
+            const auto name_id = names.find(name);
+            return name_id == string_table::invalid_id ? invalid_id : first_with_name[name_id];
+        }
+        
+        
+        // Approximate memory used by the graph in bytes.
+        std::size_t memory_usage(void) const {
+            return offsets.size() * sizeof(std::uint64_t) +
+                   targets.size() * (sizeof(id_type) + sizeof(float)) +
+                   xs.size() * 2 * sizeof(int) +
+                   name_ids.size() * sizeof(string_table::id_type) +
+                   first_with_name.size() * sizeof(id_type) +
+                   names.memory_usage();
+        }
+    private:
+        std::vector<std::uint64_t> offsets;
+        std::vector<id_type> targets;
+        std::vector<float> weights;
+        std::vector<int> xs, ys;
+        
+        string_table names;
+        std::vector<string_table::id_type> name_ids;
+        // For every name in the table, the first node that has it.
+        std::vector<id_type> first_with_name;
+        
+        
+        static csr_graph convert(const graph& g, auto&& edge_cost) {
+            csr_graph result;
+            
+            result.offsets.reserve(g.nodes.size() + 1);
+            result.xs.reserve(g.nodes.size());
+            result.ys.reserve(g.nodes.size());
+            result.name_ids.reserve(g.nodes.size());
+            
+            std::size_t edges = 0;
+            for (const auto& n : g.nodes) edges += n->neighbours.size();
+            
+            result.targets.reserve(edges);
+            result.weights.reserve(edges);
+            
+            
+            result.offsets.push_back(0);
+            
+            for (const auto& n : g.nodes) {
+                for (std::size_t i = 0; i < n->neighbours.size(); ++i) {
+                    result.targets.push_back(id_type(n->neighbours[i]->id));
+                    result.weights.push_back(edge_cost(n.get(), i));
+                }
+                
+                result.offsets.push_back(result.targets.size());
+                result.xs.push_back(n->position.x);
+                result.ys.push_back(n->position.y);
+                
+                
+                const auto name_id = result.names.intern(n->name);
+                if (name_id == result.first_with_name.size()) result.first_with_name.push_back(id_type(n->id));
+                
+                result.name_ids.push_back(name_id);
+            }
+            
+            return result;
+        }
+    };
+    
+    
+    // Any graph with the accessors of csr_graph can be searched by the CSR overloads of A_star, e.g. mapped_graph.
+    template <typename G> concept CsrGraph = requires (const G& g, csr_graph::id_type id) {
+        { g.node_count() } -> std::convertible_to<std::size_t>;
+        { g.neighbours(id) } -> std::convertible_to<std::span<const csr_graph::id_type>>;
+        { g.costs(id) } -> std::convertible_to<std::span<const float>>;
+        { g.position(id) } -> std::convertible_to<vec2i>;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/dijkstra.hpp>
+
+#include <vector>
+#include <atomic>
+#include <barrier>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    namespace detail {
+        // The distance and parent of a node are packed into a single word, so both can be updated with a single CAS.
+        // Distances are never negative, so comparing them as floats after unpacking is enough.
+        inline std::uint64_t pack_distance(float distance, std::uint32_t parent) {
+            return (std::uint64_t(std::bit_cast<std::uint32_t>(distance)) << 32) | parent;
+        }
+        
+        inline float unpack_distance(std::uint64_t packed) {
+            return std::bit_cast<float>(std::uint32_t(packed >> 32));
+        }
+        
+        inline std::uint32_t unpack_parent(std::uint64_t packed) {
+            return std::uint32_t(packed);
+        }
+    }
+    
+    
+    // Parallel single-source shortest paths using delta-stepping (Meyer & Sanders), with the edge costs stored in g.
+    // Nodes are kept in buckets of width delta. The current bucket is settled by repeatedly relaxing the light edges
+    // (cost <= delta) of its nodes in parallel, after which the heavy edges of every node settled in the bucket are relaxed once.
+    //
+    // A small delta approaches Dijkstra (little redundant work, but little parallelism per bucket), while a large delta
+    // approaches Bellman-Ford. A good starting point is the average edge cost (see default_delta), which is what the overload without delta uses.
+    //
+    // Returns the same distances as dijkstra. order contains every reachable node sorted by distance.
+    inline shortest_path_tree delta_stepping(const graph& g, const node* source, float delta, unsigned threads = std::thread::hardware_concurrency()) {
+        constexpr std::uint32_t no_parent = shortest_path_tree::no_parent;
+        constexpr float infinity = std::numeric_limits<float>::infinity();
+        
+        // Number of frontier nodes a thread claims at once.
+        constexpr std::size_t chunk_size = 64;
+        
+        
+        threads = std::max(threads, 1u);
+        const std::size_t n = g.nodes.size();
+        
+        std::vector<std::atomic<std::uint64_t>> state(n);
+        for (auto& s : state) s.store(detail::pack_distance(infinity, no_parent), std::memory_order_relaxed);
+        
+        auto bucket_of = [&](float distance) { return std::size_t(distance / delta); };
+        
+        
+        // Every thread collects the nodes it reaches in its own bins, which are merged into the shared frontier between phases.
+        struct thread_state {
+            std::vector<std::vector<std::uint32_t>> bins;
+            // Nodes settled in the current bucket, whose heavy edges still have to be relaxed.
+            std::vector<std::uint32_t> settled;
+        };
+        
+        std::vector<thread_state> workers(threads);
+        
+        std::vector<std::uint32_t> frontier { std::uint32_t(source->id) };
+        std::atomic<std::size_t> next_chunk = 0;
+        std::size_t bucket = 0;
+        
+        enum class stage { light, heavy, done } current_stage = stage::light;
+        
+        state[source->id].store(detail::pack_distance(0, no_parent), std::memory_order_relaxed);
+        
+        
+        auto relax = [&](thread_state& self, std::uint32_t v, float distance, std::uint32_t parent) {
+            std::uint64_t old = state[v].load(std::memory_order_relaxed);
+            const std::uint64_t desired = detail::pack_distance(distance, parent);
+            
+            while (distance < detail::unpack_distance(old)) {
+                if (state[v].compare_exchange_weak(old, desired, std::memory_order_relaxed)) {
+                    std::size_t b = bucket_of(distance);
+                    if (self.bins.size() <= b) self.bins.resize(b + 1);
+                    
+                    self.bins[b].push_back(v);
+                    return;
+                }
+            }
+        };
+        
+        
+        // Moves the contents of every thread's bin for bucket b into the frontier.
+        auto gather = [&](std::size_t b) {
+            frontier.clear();
+            next_chunk.store(0, std::memory_order_relaxed);
+            
+            for (auto& w : workers) {
+                if (b >= w.bins.size()) continue;
+                
+                frontier.insert(frontier.end(), w.bins[b].begin(), w.bins[b].end());
+                w.bins[b].clear();
+            }
+        };
+        
+        
+        // Runs on a single thread once every thread has finished the current phase.
+        auto on_phase_complete = [&]() noexcept {
+            if (current_stage == stage::light) {
+                // Relaxing light edges can add nodes to the current bucket again, in which case there is another light phase.
+                gather(bucket);
+                if (frontier.empty()) current_stage = stage::heavy;
+            } else {
+                std::size_t next = std::numeric_limits<std::size_t>::max();
+                
+                for (const auto& w : workers) {
+                    for (std::size_t b = bucket + 1; b < std::min(w.bins.size(), next); ++b) {
+                        if (!w.bins[b].empty()) {
+                            next = b;
+                            break;
+                        }
+                    }
+                }
+                
+                if (next == std::numeric_limits<std::size_t>::max()) {
+                    current_stage = stage::done;
+                } else {
+                    bucket = next;
+                    gather(bucket);
+                    current_stage = stage::light;
+                }
+            }
+        };
+        
+        std::barrier sync { std::ptrdiff_t(threads), on_phase_complete };
+        
+        
+        auto light_phase = [&](thread_state& self) {
+            while (true) {
+                const std::size_t begin = next_chunk.fetch_add(chunk_size, std::memory_order_relaxed);
+                if (begin >= frontier.size()) return;
+                
+                for (std::size_t i = begin; i < std::min(begin + chunk_size, frontier.size()); ++i) {
+                    const std::uint32_t u = frontier[i];
+                    const float du = detail::unpack_distance(state[u].load(std::memory_order_relaxed));
+                    
+                    // Entries are never removed when a node's distance drops, so it can still be listed in a later bucket
+                    // after it has been settled. Nodes listed more than once in this bucket are harmless, since relax only accepts improvements.
+                    if (bucket_of(du) != bucket) continue;
+                    self.settled.push_back(u);
+                    
+                    const node* current = g.nodes[u].get();
+                    for (std::size_t j = 0; j < current->neighbours.size(); ++j) {
+                        if (current->costs[j] <= delta) relax(self, std::uint32_t(current->neighbours[j]->id), du + current->costs[j], u);
+                    }
+                }
+            }
+        };
+        
+        
+        auto heavy_phase = [&](thread_state& self) {
+            std::sort(self.settled.begin(), self.settled.end());
+            self.settled.erase(std::unique(self.settled.begin(), self.settled.end()), self.settled.end());
+            
+            for (std::uint32_t u : self.settled) {
+                const float du = detail::unpack_distance(state[u].load(std::memory_order_relaxed));
+                
+                const node* current = g.nodes[u].get();
+                for (std::size_t j = 0; j < current->neighbours.size(); ++j) {
+                    if (current->costs[j] > delta) relax(self, std::uint32_t(current->neighbours[j]->id), du + current->costs[j], u);
+                }
+            }
+            
+            self.settled.clear();
+        };
+        
+        
+        auto run = [&](unsigned index) {
+            thread_state& self = workers[index];
+            
+            while (current_stage != stage::done) {
+                if (current_stage == stage::light) light_phase(self);
+                else heavy_phase(self);
+                
+                sync.arrive_and_wait();
+            }
+        };
+        
+        
+        {
+            std::vector<std::jthread> team;
+            for (unsigned i = 1; i < threads; ++i) team.emplace_back(run, i);
+            
+            run(0);
+        }
+        
+        
+        shortest_path_tree result {
+            .distance = std::vector<float>(n),
+            .parent   = std::vector<std::uint32_t>(n),
+            .order    = {}
+        };
+        
+        for (std::size_t v = 0; v < n; ++v) {
+            const std::uint64_t packed = state[v].load(std::memory_order_relaxed);
+            
+            result.distance[v] = detail::unpack_distance(packed);
+            result.parent[v]   = detail::unpack_parent(packed);
+            
+            if (result.distance[v] != infinity) result.order.push_back(std::uint32_t(v));
+        }
+        
+        std::stable_sort(result.order.begin(), result.order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return result.distance[a] < result.distance[b];
+        });
+        
+        return result;
+    }
+    
+    
+    // The average edge cost of g, which is a reasonable default for delta.
+    inline float default_delta(const graph& g) {
+        double total = 0;
+        std::size_t edges = 0;
+        
+        for (const auto& n : g.nodes) {
+            total += std::accumulate(n->costs.begin(), n->costs.end(), 0.0);
+            edges += n->costs.size();
+        }
+        
+        return edges ? std::max(float(total / edges), 1e-6f) : 1.0f;
+    }
+    
+    
+    inline shortest_path_tree delta_stepping(const graph& g, const node* source) {
+        return delta_stepping(g, source, default_delta(g));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/container/indexed_heap.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+
+namespace imp {
+    // Result of a single-source shortest path search, indexed by node::id.
+    // Nodes that cannot be reached have an infinite distance and no parent.
+    struct shortest_path_tree {
+        constexpr static std::uint32_t no_parent = std::numeric_limits<std::uint32_t>::max();
+        
+        std::vector<float> distance;
+        std::vector<std::uint32_t> parent;
+        // Every reachable node, in the order it was settled (i.e. by non-decreasing distance).
+        std::vector<std::uint32_t> order;
+    };
+    
+    
+    // Sequential Dijkstra from source to every node, using the edge costs stored in g.
+    inline shortest_path_tree dijkstra(const graph& g, const node* source) {
+        shortest_path_tree result {
+            .distance = std::vector<float>(g.nodes.size(), std::numeric_limits<float>::infinity()),
+            .parent   = std::vector<std::uint32_t>(g.nodes.size(), shortest_path_tree::no_parent),
+            .order    = {}
+        };
+        
+        indexed_heap<float, 4> open { g.nodes.size() };
+        
+        result.distance[source->id] = 0;
+        open.push(source->id, 0);
+        
+        
+        while (!open.empty()) {
+            const node* current = g.nodes[open.pop()].get();
+            const float current_distance = result.distance[current->id];
+            
+            result.order.push_back(std::uint32_t(current->id));
+            
+            
+            for (std::size_t i = 0; i < current->neighbours.size(); ++i) {
+                const node* neighbour = current->neighbours[i];
+                float tentative = current_distance + current->costs[i];
+                
+                if (tentative < result.distance[neighbour->id]) {
+                    result.distance[neighbour->id] = tentative;
+                    result.parent[neighbour->id]   = std::uint32_t(current->id);
+                    
+                    open.push_or_update(neighbour->id, tentative);
+                }
+            }
+        }
+        
+        
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/search_workspace.hpp>
+#include <imperative/contraction_hierarchy.hpp>
+#include <imperative/thread_pool.hpp>
+
+#include <vector>
+#include <span>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Dense row-major matrix of distances, with one row per source and one column per target.
+    // Unreachable pairs have an infinite distance.
+    struct distance_matrix {
+        std::size_t rows = 0, columns = 0;
+        std::vector<float> values;
+        
+        
+        float at(std::size_t row, std::size_t column) const {
+            return values[row * columns + column];
+        }
+        
+        std::span<const float> row(std::size_t index) const {
+            return { values.data() + index * columns, columns };
+        }
+    };
+    
+    
+    // Distances from source to every node in targets, using the edge costs stored in g, written to distances[i] for targets[i].
+    // A single Dijkstra search is run, which stops as soon as every target has been settled.
+    template <typename OpenSet>
+    inline void one_to_many(const graph& g, const node* source, std::span<node* const> targets, std::span<float> distances, basic_search_workspace<OpenSet>& ws) {
+        using ws_type = basic_search_workspace<OpenSet>;
+        
+        if (distances.size() < targets.size()) throw std::invalid_argument { "one_to_many: distances must have room for every target." };
+        
+        
+        // Targets are marked in a bitmap, so checking whether a settled node is a target is a single lookup.
+        std::vector<bool> is_target(g.nodes.size(), false);
+        std::size_t remaining = 0;
+        
+        for (const node* t : targets) {
+            if (!is_target[t->id]) ++remaining;
+            is_target[t->id] = true;
+        }
+        
+        
+        ws.begin_query(g.nodes.size());
+        ws.visit(source->id, 0, ws_type::no_parent);
+        ws.open.push_or_update(source->id, 0);
+        
+        while (!ws.open.empty() && remaining > 0) {
+            const node* current = g.nodes[ws.open.pop()].get();
+            const float current_gscore = ws.gscore(current->id);
+            
+            if (is_target[current->id]) --remaining;
+            
+            
+            for (std::size_t i = 0; i < current->neighbours.size(); ++i) {
+                const node* neighbour = current->neighbours[i];
+                float tentative_gscore = current_gscore + current->costs[i];
+                
+                if (tentative_gscore < ws.gscore(neighbour->id)) {
+                    ws.visit(neighbour->id, tentative_gscore, std::uint32_t(current->id));
+                    ws.open.push_or_update(neighbour->id, tentative_gscore);
+                }
+            }
+        }
+        
+        
+        for (std::size_t i = 0; i < targets.size(); ++i) distances[i] = ws.gscore(targets[i]->id);
+    }
+    
+    
+    inline std::vector<float> one_to_many(const graph& g, const node* source, std::span<node* const> targets) {
+        std::vector<float> result(targets.size());
+        search_workspace ws;
+        
+        one_to_many(g, source, targets, std::span<float> { result }, ws);
+        return result;
+    }
+    
+    
+    // Distances between every source and every target, computed as one one_to_many search per source spread across the workers of pool.
+    // g is only read, so it must not be modified until the matrix is complete.
+    template <typename OpenSet = heap_open_set>
+    inline distance_matrix many_to_many(const graph& g, std::span<node* const> sources, std::span<node* const> targets, thread_pool& pool) {
+        distance_matrix result { sources.size(), targets.size(), std::vector<float>(sources.size() * targets.size()) };
+        
+        pool.parallel_for(sources.size(), 1, [&](std::size_t begin, std::size_t end, unsigned worker) {
+            thread_local basic_search_workspace<OpenSet> ws;
+            
+            for (std::size_t i = begin; i < end; ++i) {
+                one_to_many(g, sources[i], targets, std::span<float> { result.values.data() + i * targets.size(), targets.size() }, ws);
+            }
+        });
+        
+        return result;
+    }
+    
+    
+    // Distances between every source and every target using a contraction hierarchy of the graph, with the bucket-based
+    // algorithm of Knopp et al.: the upward search space of every target is stored in buckets at the nodes it settles,
+    // then the upward search from every source scans the buckets of the nodes it settles. Both phases are spread across the workers of pool.
+    //
+    // Every search only explores a small upward search space, so this is much faster than a one_to_many search per source on large graphs.
+    template <typename OpenSet = heap_open_set>
+    inline distance_matrix many_to_many(const contraction_hierarchy& ch, std::span<node* const> sources, std::span<node* const> targets, thread_pool& pool) {
+        using id_type = contraction_hierarchy::id_type;
+        
+        struct bucket_entry {
+            id_type node;
+            std::uint32_t target;
+            float distance;
+        };
+        
+        
+        // Backward phase: collect the search spaces of the targets, then sort them by node to form the buckets.
+        std::vector<std::vector<bucket_entry>> collected(pool.size());
+        
+        pool.parallel_for(targets.size(), 1, [&](std::size_t begin, std::size_t end, unsigned worker) {
+            thread_local basic_search_workspace<OpenSet> ws;
+            
+            for (std::size_t t = begin; t < end; ++t) {
+                ch.upward_search(id_type(targets[t]->id), ws, [&](id_type n, float distance) {
+                    collected[worker].push_back(bucket_entry { n, std::uint32_t(t), distance });
+                });
+            }
+        });
+        
+        
+        std::vector<bucket_entry> entries;
+        for (auto& c : collected) entries.insert(entries.end(), c.begin(), c.end());
+        
+        std::sort(entries.begin(), entries.end(), [](const bucket_entry& a, const bucket_entry& b) { return a.node < b.node; });
+        
+        std::vector<std::uint64_t> bucket_offsets(ch.node_count() + 1, 0);
+        for (const auto& e : entries) ++bucket_offsets[e.node + 1];
+        for (std::size_t i = 1; i < bucket_offsets.size(); ++i) bucket_offsets[i] += bucket_offsets[i - 1];
+        
+        
+        // Forward phase: every source fills its own row, so the rows can be computed independently.
+        distance_matrix result {
+            sources.size(),
+            targets.size(),
+            std::vector<float>(sources.size() * targets.size(), std::numeric_limits<float>::infinity())
+        };
+        
+        pool.parallel_for(sources.size(), 1, [&](std::size_t begin, std::size_t end, unsigned worker) {
+            thread_local basic_search_workspace<OpenSet> ws;
+            
+            for (std::size_t s = begin; s < end; ++s) {
+                float* row = result.values.data() + s * targets.size();
+                
+                ch.upward_search(id_type(sources[s]->id), ws, [&](id_type n, float distance) {
+                    for (std::uint64_t i = bucket_offsets[n]; i < bucket_offsets[n + 1]; ++i) {
+                        row[entries[i].target] = std::min(row[entries[i].target], distance + entries[i].distance);
+                    }
+                });
+            }
+        });
+        
+        
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <imperative/csr_graph.hpp>
+#include <imperative/thread_pool.hpp>
+
+#include <vector>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <charconv>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <tuple>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    namespace detail {
+        // Reads whitespace-separated numbers from a single line with std::from_chars.
+        class field_reader {
+        public:
+            explicit field_reader(std::string_view line) : pos(line.data()), end(line.data() + line.size()) {}
+            
+            
+            template <typename T> bool next(T& value) {
+                skip_blanks();
+                
+                // Costs are usually integers, which are much faster to parse as such. Integers of up to 7 digits are exact as a float.
+                if constexpr (std::is_floating_point_v<T>) {
+                    const char* digit = pos;
+                    std::uint32_t integer = 0;
+                    
+                    while (digit != end && digit - pos < 7 && unsigned(*digit - '0') < 10) integer = integer * 10 + unsigned(*digit++ - '0');
+                    
+                    if (digit != pos && (digit == end || is_blank(*digit))) {
+                        value = T(integer);
+                        pos = digit;
+                        return true;
+                    }
+                }
+                
+                
+                auto [next, error] = std::from_chars(pos, end, value);
+                if (error != std::errc {}) return false;
+                
+                pos = next;
+                return true;
+            }
+            
+            
+            // Reads a word, which must be equal to expected.
+            bool expect(std::string_view expected) {
+                skip_blanks();
+                
+                if (std::string_view { pos, std::size_t(end - pos) }.substr(0, expected.size()) != expected) return false;
+                
+                pos += expected.size();
+                return pos == end || is_blank(*pos);
+            }
+            
+            
+            bool at_end(void) {
+                skip_blanks();
+                return pos == end;
+            }
+        private:
+            const char* pos;
+            const char* end;
+            
+            
+            static bool is_blank(char c) {
+                return c == ' ' || c == '\t' || c == '\r';
+            }
+            
+            void skip_blanks(void) {
+                while (pos != end && is_blank(*pos)) ++pos;
+            }
+        };
+        
+        
+        // Invokes fn(text, offset) for consecutive blocks of at most chunk_size bytes of the file, where every block ends at the end of a line
+        // and offset is the position of the block in the file. The next block is read in the background while fn runs,
+        // so at most two blocks are held in memory at a time.
+        template <typename F> inline void for_each_chunk(const std::string& path, std::size_t chunk_size, F&& fn) {
+            std::ifstream stream { path, std::ios::binary };
+            if (!stream) throw std::runtime_error { "Failed to open edge list: " + path };
+            
+            // Files smaller than a block don't need buffers of the full block size.
+            stream.seekg(0, std::ios::end);
+            chunk_size = std::min(chunk_size, std::size_t(stream.tellg()) + 1);
+            stream.seekg(0, std::ios::beg);
+            
+            
+            // Fills buffer after the first carried bytes, and returns the number of bytes in it.
+            auto read = [&](std::vector<char>& buffer, std::size_t carried) {
+                stream.read(buffer.data() + carried, std::streamsize(chunk_size - carried));
+                if (stream.bad()) throw std::runtime_error { "Failed to read edge list: " + path };
+                
+                return carried + std::size_t(stream.gcount());
+            };
+            
+            
+            std::vector<char> current(chunk_size), next(chunk_size);
+            std::size_t size = read(current, 0);
+            std::uint64_t offset = 0;
+            
+            while (size > 0) {
+                const bool last = !stream;
+                
+                
+                // Lines that don't fit in the block are carried over to the next one. The last line of the file doesn't need a newline.
+                std::size_t length = size;
+                
+                if (!last) {
+                    while (length > 0 && current[length - 1] != '\n') --length;
+                    if (length == 0) throw std::runtime_error { "Edge list contains a line longer than the chunk size: " + path };
+                }
+                
+                const std::size_t carried = size - length;
+                std::copy(current.begin() + std::ptrdiff_t(length), current.begin() + std::ptrdiff_t(size), next.begin());
+                
+                
+                std::future<std::size_t> next_size;
+                if (!last) next_size = std::async(std::launch::async, read, std::ref(next), carried);
+                
+                fn(std::string_view { current.data(), length }, offset);
+                
+                
+                offset += length;
+                size = last ? 0 : next_size.get();
+                std::swap(current, next);
+            }
+        }
+        
+        
+        // Splits text into about count parts, each ending at the end of a line.
+        inline std::vector<std::string_view> split_lines(std::string_view text, std::size_t count) {
+            std::vector<std::string_view> result;
+            std::size_t begin = 0;
+            
+            for (std::size_t i = 1; i <= count && begin < text.size(); ++i) {
+                std::size_t end = i == count ? text.size() : std::max(begin, text.size() * i / count);
+                
+                end = text.find('\n', end);
+                end = (end == std::string_view::npos) ? text.size() : end + 1;
+                
+                result.push_back(text.substr(begin, end - begin));
+                begin = end;
+            }
+            
+            return result;
+        }
+        
+        
+        // Invokes fn(line, offset) for every line of text, where offset is the position of the line within text.
+        template <typename F> inline void for_each_line(std::string_view text, F&& fn) {
+            std::size_t begin = 0;
+            
+            while (begin < text.size()) {
+                std::size_t end = text.find('\n', begin);
+                if (end == std::string_view::npos) end = text.size();
+                
+                fn(text.substr(begin, end - begin), begin);
+                begin = end + 1;
+            }
+        }
+    }
+    
+    
+    // Loads a graph from a text file in the format of the DIMACS shortest path challenge, without going through an imp::graph.
+    // The file consists of the following lines, where node IDs start at 1:
+    // c <text>                 comment
+    // p sp <nodes> <edges>     problem line, which must come before any other line except comments
+    // a <from> <to> <cost>     directed edge, with a finite and non-negative cost
+    // v <id> <x> <y>           position of a node (read from a separate .co file in the original format); nodes without one are at the origin.
+    //                          A second v line for the same node is malformed.
+    //
+    // The file is streamed in blocks of chunk_size bytes, and the lines of every block are parsed by the workers of pool.
+    // The graph is built in two passes over the file: the first counts the edges of every node, which gives the CSR offsets,
+    // and the second writes every edge straight into its place. Node IDs in the result are one less than in the file,
+    // and the neighbours of every node are ordered by ID so the result doesn't depend on the order the workers run in.
+    //
+    // Throws a std::runtime_error with the byte offset of a malformed line if the file is malformed,
+    // or if the number of edges differs from the problem line.
+    inline csr_graph load_edge_list(const std::string& path, thread_pool& pool, std::size_t chunk_size = std::size_t(64) << 20) {
+        using id_type = csr_graph::id_type;
+        
+        
+        auto malformed = [&](std::uint64_t offset) {
+            return std::runtime_error { "Malformed line in edge list " + path + " at byte " + std::to_string(offset) };
+        };
+        
+        
+        // Parses the blocks of the file in parallel, invoking fn(tag, fields) for every line that isn't a comment or the problem line.
+        // fn returns false if the line is malformed.
+        auto parse_file = [&](auto&& on_problem_line, auto&& fn) {
+            bool found_problem_line = false;
+            
+            detail::for_each_chunk(path, chunk_size, [&](std::string_view text, std::uint64_t offset) {
+                // The problem line is read on this thread, before the rest of the first block is handed to the workers.
+                while (!found_problem_line && !text.empty()) {
+                    const std::size_t end = std::min(text.find('\n'), text.size());
+                    const std::string_view line = text.substr(0, end);
+                    
+                    if (!line.empty() && line[0] == 'p') {
+                        on_problem_line(detail::field_reader { line.substr(1) }, offset);
+                        found_problem_line = true;
+                    } else if (!line.empty() && line[0] != 'c' && !detail::field_reader { line }.at_end()) {
+                        throw std::runtime_error { "Edge list has no problem line before its first line: " + path };
+                    }
+                    
+                    const std::size_t skipped = std::min(end + 1, text.size());
+                    text.remove_prefix(skipped);
+                    offset += skipped;
+                }
+                
+                
+                auto parts = detail::split_lines(text, 4 * pool.size());
+                
+                pool.parallel_for(parts.size(), 1, [&](std::size_t begin, std::size_t end, unsigned worker) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        const std::uint64_t part_offset = offset + std::uint64_t(parts[i].data() - text.data());
+                        
+                        detail::for_each_line(parts[i], [&](std::string_view line, std::size_t line_offset) {
+                            if (line.empty() || line[0] == 'c') return;
+                            
+                            detail::field_reader fields { line.substr(1) };
+                            if (!fn(line[0], fields)) throw malformed(part_offset + line_offset);
+                        });
+                    }
+                });
+            });
+            
+            if (!found_problem_line) throw std::runtime_error { "Edge list has no problem line: " + path };
+        };
+        
+        
+        std::uint64_t nodes = 0, declared_edges = 0;
+        std::vector<int> xs, ys;
+        std::vector<std::atomic<std::uint32_t>> degrees;
+        // Set for nodes that have a position, so a second v line for the same node is rejected rather than racing with the first.
+        std::vector<std::atomic<bool>> positioned;
+        
+        
+        // First pass: read the problem line and the positions, and count the edges leaving every node.
+        parse_file(
+            [&](detail::field_reader fields, std::uint64_t offset) {
+                if (!fields.expect("sp") || !fields.next(nodes) || !fields.next(declared_edges) || !fields.at_end()) throw malformed(offset);
+                if (nodes >= csr_graph::invalid_id) throw std::runtime_error { "Edge list has too many nodes: " + path };
+                
+                xs.assign(nodes, 0);
+                ys.assign(nodes, 0);
+                degrees = std::vector<std::atomic<std::uint32_t>>(nodes);
+                positioned = std::vector<std::atomic<bool>>(nodes);
+            },
+            [&](char tag, detail::field_reader& fields) {
+                std::uint64_t id = 0, to = 0;
+                float cost = 0;
+                int x = 0, y = 0;
+                
+                switch (tag) {
+                    case 'a':
+                        if (!fields.next(id) || !fields.next(to) || !fields.next(cost) || !fields.at_end()) return false;
+                        if (id == 0 || id > nodes || to == 0 || to > nodes) return false;
+                        if (!(cost >= 0) || !std::isfinite(cost)) return false;
+                        
+                        degrees[id - 1].fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    case 'v':
+                        if (!fields.next(id) || !fields.next(x) || !fields.next(y) || !fields.at_end()) return false;
+                        if (id == 0 || id > nodes) return false;
+                        if (positioned[id - 1].exchange(true, std::memory_order_relaxed)) return false;
+                        
+                        xs[id - 1] = x;
+                        ys[id - 1] = y;
+                        return true;
+                    default:
+                        // Lines with only whitespace are ignored.
+                        return (tag == ' ' || tag == '\t' || tag == '\r') && fields.at_end();
+                }
+            }
+        );
+        
+        
+        std::vector<std::uint64_t> offsets(nodes + 1, 0);
+        
+        for (std::uint64_t i = 0; i < nodes; ++i) {
+            offsets[i + 1] = offsets[i] + degrees[i].load(std::memory_order_relaxed);
+            degrees[i].store(0, std::memory_order_relaxed);
+        }
+        
+        if (offsets.back() != declared_edges) throw std::runtime_error { "Edge list contains a different number of edges than its problem line: " + path };
+        
+        
+        // Second pass: write every edge into the next free slot of its source node. The degrees are reused as the count of filled slots.
+        std::vector<id_type> targets(offsets.back());
+        std::vector<float> weights(offsets.back());
+        
+        parse_file(
+            [](detail::field_reader fields, std::uint64_t offset) {},
+            [&](char tag, detail::field_reader& fields) {
+                if (tag != 'a') return true;
+                
+                std::uint64_t from = 0, to = 0;
+                float cost = 0;
+                
+                fields.next(from);
+                fields.next(to);
+                fields.next(cost);
+                
+                // The file was checked by the first pass, so this only fails if it was changed in between.
+                const std::uint64_t slot = offsets[from - 1] + degrees[from - 1].fetch_add(1, std::memory_order_relaxed);
+                if (slot >= offsets[from]) return false;
+                
+                targets[slot] = id_type(to - 1);
+                weights[slot] = cost;
+                
+                return true;
+            }
+        );
+        
+        
+        // Edges were placed in whatever order the workers reached them, so sort the edges of every node to make the result deterministic.
+        pool.parallel_for(nodes, 1 << 14, [&](std::size_t begin, std::size_t end, unsigned worker) {
+            thread_local std::vector<std::pair<id_type, float>> edges;
+            
+            for (std::size_t i = begin; i < end; ++i) {
+                edges.clear();
+                for (std::uint64_t e = offsets[i]; e < offsets[i + 1]; ++e) edges.emplace_back(targets[e], weights[e]);
+                
+                std::sort(edges.begin(), edges.end());
+                
+                for (std::uint64_t e = offsets[i]; e < offsets[i + 1]; ++e) std::tie(targets[e], weights[e]) = edges[e - offsets[i]];
+            }
+        });
+        
+        
+        return csr_graph::from_arrays(std::move(offsets), std::move(targets), std::move(weights), std::move(xs), std::move(ys));
+    }
+}
\ No newline at end of file
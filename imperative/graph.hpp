@@ -5,6 +5,9 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
 
 
 namespace imp {
@@ -13,29 +16,74 @@ namespace imp {
         vec2i position;
         
         std::vector<node*> neighbours;
+        // Cost of traversing the edge to the neighbour at the same index.
+        std::vector<float> costs;
+        
+        // Index of this node within graph::nodes, used to key dense per-node arrays during searches.
+        std::size_t id = 0;
         
         
         node(void) = default;
-        node(std::string&& name, vec2i pos) : name(std::move(name)), position(pos) {}
+        node(std::string&& name, vec2i pos, std::size_t id) : name(std::move(name)), position(pos), id(id) {}
+        
+        
+        // Returns the index of the edge to other in neighbours and costs, or neighbours.size() if there is no such edge.
+        std::size_t edge_index(const node& other) const {
+            return std::size_t(std::find(neighbours.begin(), neighbours.end(), &other) - neighbours.begin());
+        }
     };
     
-
-struct graph {
-std::vector<std::unique_ptr<node>> nodes;
-
-
-node& add_node(std::string&& name, vec2i where) {
-nodes.emplace_back(
-std::make_unique<node>(std::move(name), where)
-);
-
-return *nodes.back();
-}
-
-
-void add_edge(node& from, node& to) {
-from.neighbours.push_back(&to);
-to.neighbours.push_back(&from);
+    
+    struct graph {
+        std::vector<std::unique_ptr<node>> nodes;
+        
+        // Incremented by every change made through the methods below, so cached search results can tell when they are stale.
+        // Code that changes nodes or costs directly must increment it as well.
+        std::uint64_t version = 0;
+        
+        
+        node& add_node(std::string&& name, vec2i where) {
+            ++version;
+            
+            nodes.emplace_back(
+                std::make_unique<node>(std::move(name), where, nodes.size())
+            );
+            
+            return *nodes.back();
+        }
+        
+        
+        // Adds an edge whose cost is the distance between the two nodes.
+        void add_edge(node& from, node& to) {
+            add_edge(from, to, distance(from.position, to.position));
+        }
+        
+        
+        void add_edge(node& from, node& to, float cost) {
+            ++version;
+            
+            from.neighbours.push_back(&to);
+            from.costs.push_back(cost);
+            
+            to.neighbours.push_back(&from);
+            to.costs.push_back(cost);
+        }
+        
+        
+        // Changes the cost of the edge between a and b in both directions. Returns false if there is no such edge.
+        bool set_edge_cost(node& a, node& b, float cost) {
+            std::size_t ab = a.edge_index(b), ba = b.edge_index(a);
+            if (ab == a.neighbours.size() || ba == b.neighbours.size()) return false;
+            
+            a.costs[ab] = cost;
+            b.costs[ba] = cost;
+            
+            ++version;
+            return true;
+        }
+        
+        
+        // Recomputes the stored cost of every edge using d, which can be any CostPolicy. Defined in cost_function.hpp.
+        template <typename D> void bake_costs(D&& d);
+    };
 }
-};
-}
\ No newline at end of file
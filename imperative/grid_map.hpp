@@ -0,0 +1,201 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/common.hpp>
+
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <string>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Dense view of a graph that forms a uniform-cost 8-connected grid: every node lies on an integer lattice,
+    // orthogonal neighbours are connected with cost 1 and diagonal neighbours with cost sqrt(2),
+    // as long as both orthogonal cells in between are open (no corner cutting).
+    //
+    // Cells are stored with a border of blocked cells around the grid, so the search engines can look at the
+    // neighbours of any open cell without bounds checks. Cell indices used by the engines refer to this padded layout.
+    class grid_map {
+    public:
+        constexpr static std::size_t no_cell = std::numeric_limits<std::size_t>::max();
+        
+        
+        grid_map(void) = default;
+        
+        
+        // Creates a width x height grid in g. A node is added for each cell (x, y) for which passable(x, y) is true,
+        // in row-major order, and every pair of neighbouring open cells is connected.
+        template <typename Passable>
+        static grid_map create(graph& g, int width, int height, Passable&& passable) {
+            grid_map result { { 0, 0 }, width, height };
+            
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    if (!passable(x, y)) continue;
+                    result.set(x, y, &g.add_node(std::to_string(x) + "," + std::to_string(y), { x, y }));
+                }
+            }
+            
+            
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    node* n = result.at(x, y);
+                    if (!n) continue;
+                    
+                    node* right = result.at(x + 1, y);
+                    node* down  = result.at(x, y + 1);
+                    
+                    if (right) g.add_edge(*n, *right);
+                    if (down)  g.add_edge(*n, *down);
+                    
+                    if (right && down && result.at(x + 1, y + 1)) g.add_edge(*n, *result.at(x + 1, y + 1));
+                    if (down && result.at(x - 1, y) && result.at(x - 1, y + 1)) g.add_edge(*n, *result.at(x - 1, y + 1));
+                }
+            }
+            
+            
+            return result;
+        }
+        
+        
+        // Returns a grid_map for g if it has exactly the structure described above, or std::nullopt otherwise.
+        // Graphs whose bounding box is much larger than their node count are rejected as well,
+        // since the dense representation would waste too much memory.
+        static std::optional<grid_map> detect(const graph& g) {
+            if (g.nodes.empty()) return std::nullopt;
+            
+            vec2i min = g.nodes.front()->position, max = min;
+            for (const auto& n : g.nodes) {
+                min = { std::min(min.x, n->position.x), std::min(min.y, n->position.y) };
+                max = { std::max(max.x, n->position.x), std::max(max.y, n->position.y) };
+            }
+            
+            const std::int64_t width  = std::int64_t(max.x) - min.x + 1;
+            const std::int64_t height = std::int64_t(max.y) - min.y + 1;
+            if (width * height > 16 * std::int64_t(g.nodes.size()) + 1024) return std::nullopt;
+            
+            
+            grid_map result { min, int(width), int(height) };
+            
+            for (const auto& n : g.nodes) {
+                vec2i p = result.local(n->position);
+                if (result.at(p.x, p.y)) return std::nullopt;
+                
+                result.set(p.x, p.y, n.get());
+            }
+            
+            
+            for (const auto& n : g.nodes) {
+                const vec2i p = result.local(n->position);
+                
+                std::size_t expected = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        if ((dx || dy) && result.connected(p, dx, dy)) ++expected;
+                    }
+                }
+                
+                if (n->neighbours.size() != expected) return std::nullopt;
+                
+                
+                // Every edge must go to a distinct valid neighbour and have the uniform grid cost.
+                unsigned seen = 0;
+                
+                for (std::size_t i = 0; i < n->neighbours.size(); ++i) {
+                    const vec2i q = n->neighbours[i]->position;
+                    const int dx = q.x - n->position.x, dy = q.y - n->position.y;
+                    
+                    if (std::abs(dx) > 1 || std::abs(dy) > 1 || !result.connected(p, dx, dy)) return std::nullopt;
+                    
+                    unsigned bit = 1u << ((dy + 1) * 3 + (dx + 1));
+                    if (seen & bit) return std::nullopt;
+                    seen |= bit;
+                    
+                    const float cost = (dx && dy) ? std::sqrt(2.0f) : 1.0f;
+                    if (std::abs(n->costs[i] - cost) > 1e-4f) return std::nullopt;
+                }
+            }
+            
+            
+            return result;
+        }
+        
+        
+        int get_width(void) const { return width; }
+        int get_height(void) const { return height; }
+        vec2i get_origin(void) const { return origin; }
+        
+        
+        // Returns the node at (x, y), relative to the origin of the grid, or nullptr if the cell is blocked or out of bounds.
+        node* at(int x, int y) const {
+            if (x < 0 || y < 0 || x >= width || y >= height) return nullptr;
+            return cells[index(x, y)];
+        }
+        
+        bool passable(int x, int y) const {
+            return at(x, y) != nullptr;
+        }
+        
+        
+        // Padded cell layout, used by the search engines.
+        std::size_t cell_count(void) const { return open.size(); }
+        std::size_t get_stride(void) const { return stride; }
+        
+        bool is_open(std::size_t cell) const { return open[cell]; }
+        node* node_at(std::size_t cell) const { return cells[cell]; }
+        
+        // Returns the padded cell index of n, or no_cell if n is not part of this grid.
+        std::size_t cell_of(const node* n) const {
+            vec2i p = local(n->position);
+            return (at(p.x, p.y) == n) ? index(p.x, p.y) : no_cell;
+        }
+        
+        // Coordinates of a cell within the padded layout.
+        vec2i coordinates(std::size_t cell) const {
+            return { int(cell % stride), int(cell / stride) };
+        }
+    private:
+        vec2i origin = { 0, 0 };
+        int width = 0, height = 0;
+        std::size_t stride = 0;
+        
+        std::vector<node*> cells;
+        std::vector<std::uint8_t> open;
+        
+        
+        grid_map(vec2i origin, int width, int height) :
+            origin(origin),
+            width(width),
+            height(height),
+            stride(std::size_t(width) + 2),
+            cells(stride * (std::size_t(height) + 2), nullptr),
+            open(cells.size(), 0)
+        {}
+        
+        
+        std::size_t index(int x, int y) const {
+            return (std::size_t(y) + 1) * stride + std::size_t(x) + 1;
+        }
+        
+        vec2i local(vec2i position) const {
+            return { position.x - origin.x, position.y - origin.y };
+        }
+        
+        void set(int x, int y, node* n) {
+            cells[index(x, y)] = n;
+            open[index(x, y)] = 1;
+        }
+        
+        
+        // True if the open cell p should be connected to its neighbour in direction (dx, dy).
+        bool connected(vec2i p, int dx, int dy) const {
+            if (!passable(p.x + dx, p.y + dy)) return false;
+            return !(dx && dy) || (passable(p.x + dx, p.y) && passable(p.x, p.y + dy));
+        }
+    };
+}
\ No newline at end of file
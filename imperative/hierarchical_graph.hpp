@@ -0,0 +1,510 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/container/indexed_heap.hpp>
+
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    class hierarchical_graph;
+    
+    
+    // Result of hierarchical_graph::find_path: a list of waypoints that still has to be refined into a path through the graph.
+    // Consecutive waypoints are either in the same cluster, or connected by a single edge between two clusters.
+    // Segments can be refined one at a time, so a unit can start moving before the rest of the path is known.
+    class hierarchical_path {
+    public:
+        bool empty(void) const { return waypoints.empty(); }
+        float get_cost(void) const { return cost; }
+        
+        const std::vector<node*>& get_waypoints(void) const { return waypoints; }
+        std::size_t segment_count(void) const { return waypoints.empty() ? 0 : waypoints.size() - 1; }
+        
+        
+        // Returns the path from waypoint i to waypoint i + 1, including both of them.
+        std::vector<node*> refine_segment(std::size_t i) const;
+        
+        // Refines every segment and returns the complete path.
+        std::vector<node*> refine(void) const;
+    private:
+        friend class hierarchical_graph;
+        
+        const hierarchical_graph* owner = nullptr;
+        std::vector<node*> waypoints;
+        float cost = std::numeric_limits<float>::infinity();
+    };
+    
+    
+    // HPA* (Botea, Müller & Schaeffer): an abstraction of a graph, used to answer queries on large maps
+    // without searching through every node between the start and the goal.
+    //
+    // Nodes are divided into square clusters by their position. Wherever edges cross between two clusters, one or two
+    // of them are chosen per entrance as transitions, and their endpoints become entrance nodes of the abstract graph.
+    // The costs between all entrances of a cluster are precomputed, so queries only search the clusters of the start and goal
+    // and the abstract graph. The resulting paths are close to optimal, but not necessarily optimal.
+    //
+    // Edge costs are read from the graph. After changing the cost of an edge, call edge_cost_changed to rebuild the affected clusters.
+    // Nodes must not be added to the graph after the hierarchy is built. Queries use internal scratch space, so a hierarchical_graph
+    // must not be used by multiple threads at the same time.
+    class hierarchical_graph {
+    public:
+        hierarchical_graph(void) = default;
+        
+        
+        static hierarchical_graph build(const graph& g, int cluster_size = 32) {
+            hierarchical_graph result;
+            result.g = &g;
+            result.cluster_size = std::max(cluster_size, 1);
+            
+            if (g.nodes.empty()) return result;
+            
+            
+            vec2i min = g.nodes.front()->position, max = min;
+            for (const auto& n : g.nodes) {
+                min = { std::min(min.x, n->position.x), std::min(min.y, n->position.y) };
+                max = { std::max(max.x, n->position.x), std::max(max.y, n->position.y) };
+            }
+            
+            result.origin  = min;
+            result.columns = (max.x - min.x) / result.cluster_size + 1;
+            result.rows    = (max.y - min.y) / result.cluster_size + 1;
+            result.clusters.resize(std::size_t(result.columns) * result.rows);
+            
+            
+            result.local_index.resize(g.nodes.size());
+            
+            for (const auto& n : g.nodes) {
+                auto& c = result.clusters[result.cluster_of(n.get())];
+                
+                result.local_index[n->id] = std::uint32_t(c.nodes.size());
+                c.nodes.push_back(std::uint32_t(n->id));
+            }
+            
+            
+            // Every pair of clusters is handled from the side of the cluster with the lowest index.
+            for (std::uint32_t c = 0; c < result.clusters.size(); ++c) {
+                for (std::uint32_t d : result.connected_clusters(c)) {
+                    if (c < d) result.compute_transitions(c, d);
+                }
+            }
+            
+            for (std::uint32_t c = 0; c < result.clusters.size(); ++c) result.compute_entrances(c);
+            
+            
+            return result;
+        }
+        
+        
+        // Finds a path between from and to on the abstract graph. h is used as the heuristic for the abstract search.
+        template <CostPolicy H>
+        hierarchical_path find_path(node* from, node* to, H&& h) {
+            hierarchical_path result;
+            result.owner = this;
+            
+            const std::uint32_t start_cluster = cluster_of(from), goal_cluster = cluster_of(to);
+            const auto& start_entrances = clusters[start_cluster].entrances;
+            const auto& goal_entrances  = clusters[goal_cluster].entrances;
+            
+            
+            // Connect the start and goal to the entrances of their clusters.
+            local_search(start_cluster, from);
+            
+            std::vector<float> from_start(start_entrances.size());
+            for (std::size_t i = 0; i < start_entrances.size(); ++i) from_start[i] = scratch.distance[local_index[start_entrances[i]]];
+            
+            const float direct = (start_cluster == goal_cluster) ? scratch.distance[local_index[to->id]] : infinity;
+            
+            
+            local_search(goal_cluster, to);
+            
+            std::vector<float> to_goal(goal_entrances.size());
+            for (std::size_t i = 0; i < goal_entrances.size(); ++i) to_goal[i] = scratch.distance[local_index[goal_entrances[i]]];
+            
+            
+            // A* over the abstract graph. Only a small part of it is visited, so the search state is kept in a hash map.
+            struct record {
+                float gscore;
+                std::uint32_t parent;
+            };
+            
+            using open_entry = std::pair<float, std::uint32_t>;
+            
+            std::unordered_map<std::uint32_t, record> records;
+            std::priority_queue<open_entry, std::vector<open_entry>, std::greater<open_entry>> open;
+            
+            
+            auto relax = [&](std::uint32_t n, float gscore, std::uint32_t parent) {
+                if (gscore == infinity) return;
+                
+                auto [it, inserted] = records.try_emplace(n, record { infinity, no_node });
+                if (gscore >= it->second.gscore) return;
+                
+                it->second = record { gscore, parent };
+                open.emplace(gscore + h.cost(g->nodes[n].get(), to), n);
+            };
+            
+            
+            relax(std::uint32_t(from->id), 0, no_node);
+            
+            while (!open.empty()) {
+                auto [fscore, current] = open.top();
+                open.pop();
+                
+                const float gscore = records[current].gscore;
+                if (fscore > gscore + h.cost(g->nodes[current].get(), to)) continue;
+                
+                if (current == to->id) break;
+                
+                
+                if (current == from->id) {
+                    for (std::size_t i = 0; i < start_entrances.size(); ++i) relax(start_entrances[i], from_start[i], current);
+                    relax(std::uint32_t(to->id), direct, current);
+                }
+                
+                
+                const std::uint32_t c = cluster_of(g->nodes[current].get());
+                const auto& entrances = clusters[c].entrances;
+                
+                if (auto it = std::lower_bound(entrances.begin(), entrances.end(), current); it != entrances.end() && *it == current) {
+                    const std::size_t index = std::size_t(it - entrances.begin());
+                    
+                    for (std::size_t i = 0; i < entrances.size(); ++i) {
+                        relax(entrances[i], gscore + clusters[c].distances[index * entrances.size() + i], current);
+                    }
+                    
+                    for (const auto& t : clusters[c].transitions) {
+                        if (t.from == current) relax(t.to, gscore + t.cost, current);
+                    }
+                    
+                    if (c == goal_cluster) {
+                        auto goal_index = std::size_t(std::lower_bound(goal_entrances.begin(), goal_entrances.end(), current) - goal_entrances.begin());
+                        relax(std::uint32_t(to->id), gscore + to_goal[goal_index], current);
+                    }
+                }
+            }
+            
+            
+            auto goal = records.find(std::uint32_t(to->id));
+            if (goal == records.end()) return result;
+            
+            result.cost = goal->second.gscore;
+            
+            for (std::uint32_t n = std::uint32_t(to->id); n != no_node; n = records[n].parent) result.waypoints.push_back(g->nodes[n].get());
+            std::reverse(result.waypoints.begin(), result.waypoints.end());
+            
+            return result;
+        }
+        
+        
+        hierarchical_path find_path(node* from, node* to) {
+            return find_path(from, to, euclidean_cost {});
+        }
+        
+        
+        // Returns the path between two waypoints of a hierarchical_path, including both of them.
+        std::vector<node*> refine_segment(node* from, node* to) const {
+            const std::uint32_t c = cluster_of(from);
+            if (c != cluster_of(to)) return { from, to };
+            
+            local_search(c, from, to);
+            
+            
+            const auto& nodes = clusters[c].nodes;
+            std::vector<node*> result;
+            
+            for (std::uint32_t i = local_index[to->id]; i != no_node; i = scratch.parent[i]) result.push_back(g->nodes[nodes[i]].get());
+            
+            std::reverse(result.begin(), result.end());
+            return result;
+        }
+        
+        
+        // Must be called after the cost of the edge between a and b has changed.
+        // Only the clusters of a and b and the clusters next to them are rebuilt.
+        void edge_cost_changed(const node& a, const node& b) {
+            std::vector<std::uint32_t> changed { cluster_of(&a), cluster_of(&b) };
+            
+            
+            // The transitions of every pair of clusters that includes a changed cluster are recomputed.
+            // That changes the entrances on both sides, so the other cluster of each pair needs new entrance costs as well.
+            std::vector<std::uint32_t> rebuilt;
+            
+            for (std::uint32_t c : changed) {
+                std::vector<std::uint32_t> others = connected_clusters(c);
+                for (const auto& t : clusters[c].transitions) others.push_back(t.other_cluster);
+                
+                std::sort(others.begin(), others.end());
+                others.erase(std::unique(others.begin(), others.end()), others.end());
+                
+                for (std::uint32_t d : others) compute_transitions(std::min(c, d), std::max(c, d));
+                
+                rebuilt.push_back(c);
+                rebuilt.insert(rebuilt.end(), others.begin(), others.end());
+            }
+            
+            std::sort(rebuilt.begin(), rebuilt.end());
+            rebuilt.erase(std::unique(rebuilt.begin(), rebuilt.end()), rebuilt.end());
+            
+            for (std::uint32_t c : rebuilt) compute_entrances(c);
+        }
+        
+        
+        std::size_t cluster_count(void) const { return clusters.size(); }
+        
+        std::size_t entrance_count(void) const {
+            std::size_t result = 0;
+            for (const auto& c : clusters) result += c.entrances.size();
+            
+            return result;
+        }
+    private:
+        constexpr static std::uint32_t no_node = std::numeric_limits<std::uint32_t>::max();
+        constexpr static float infinity = std::numeric_limits<float>::infinity();
+        
+        // Entrances with this many crossing edges or more get a transition at both ends instead of one in the middle.
+        constexpr static std::size_t long_entrance = 6;
+        
+        
+        // An edge between an entrance of this cluster and an entrance of another cluster.
+        struct transition {
+            std::uint32_t from, to;
+            float cost;
+            std::uint32_t other_cluster;
+        };
+        
+        struct cluster {
+            // IDs of the nodes in this cluster. local_index maps a node ID to its index in this list.
+            std::vector<std::uint32_t> nodes;
+            std::vector<transition> transitions;
+            
+            // Sorted IDs of the entrance nodes, and the cost between every pair of them within this cluster (row-major).
+            std::vector<std::uint32_t> entrances;
+            std::vector<float> distances;
+        };
+        
+        // Scratch space for searches within a single cluster, indexed by local index.
+        struct local_workspace {
+            std::vector<float> distance;
+            std::vector<std::uint32_t> parent;
+            indexed_heap<float, 4> open;
+        };
+        
+        
+        const graph* g = nullptr;
+        int cluster_size = 1;
+        vec2i origin = { 0, 0 };
+        int columns = 0, rows = 0;
+        
+        std::vector<cluster> clusters;
+        std::vector<std::uint32_t> local_index;
+        
+        mutable local_workspace scratch;
+        
+        
+        std::uint32_t cluster_of(const node* n) const {
+            const int x = (n->position.x - origin.x) / cluster_size;
+            const int y = (n->position.y - origin.y) / cluster_size;
+            
+            return std::uint32_t(y * columns + x);
+        }
+        
+        
+        // Clusters that share at least one edge with c.
+        std::vector<std::uint32_t> connected_clusters(std::uint32_t c) const {
+            std::vector<std::uint32_t> result;
+            
+            for (std::uint32_t id : clusters[c].nodes) {
+                for (const node* neighbour : g->nodes[id]->neighbours) {
+                    std::uint32_t d = cluster_of(neighbour);
+                    if (d != c) result.push_back(d);
+                }
+            }
+            
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            
+            return result;
+        }
+        
+        
+        // Dijkstra from source, restricted to the nodes of cluster c. Stops early once target is settled, if one is given.
+        void local_search(std::uint32_t c, const node* source, const node* target = nullptr) const {
+            const auto& nodes = clusters[c].nodes;
+            
+            scratch.distance.assign(nodes.size(), infinity);
+            scratch.parent.assign(nodes.size(), no_node);
+            scratch.open.clear();
+            scratch.open.reserve_indices(nodes.size());
+            
+            scratch.distance[local_index[source->id]] = 0;
+            scratch.open.push(local_index[source->id], 0);
+            
+            
+            while (!scratch.open.empty()) {
+                const std::uint32_t current = std::uint32_t(scratch.open.pop());
+                if (target && current == local_index[target->id]) return;
+                
+                const node* n = g->nodes[nodes[current]].get();
+                
+                for (std::size_t i = 0; i < n->neighbours.size(); ++i) {
+                    if (cluster_of(n->neighbours[i]) != c) continue;
+                    
+                    const std::uint32_t neighbour = local_index[n->neighbours[i]->id];
+                    const float tentative = scratch.distance[current] + n->costs[i];
+                    
+                    if (tentative < scratch.distance[neighbour]) {
+                        scratch.distance[neighbour] = tentative;
+                        scratch.parent[neighbour] = current;
+                        scratch.open.push_or_update(neighbour, tentative);
+                    }
+                }
+            }
+        }
+        
+        
+        // Recomputes the transitions between clusters c and d, where c < d.
+        void compute_transitions(std::uint32_t c, std::uint32_t d) {
+            std::erase_if(clusters[c].transitions, [&](const transition& t) { return t.other_cluster == d; });
+            std::erase_if(clusters[d].transitions, [&](const transition& t) { return t.other_cluster == c; });
+            
+            
+            struct crossing {
+                const node* inside;
+                const node* outside;
+                float cost;
+            };
+            
+            std::vector<crossing> crossings;
+            
+            for (std::uint32_t id : clusters[c].nodes) {
+                const node* n = g->nodes[id].get();
+                
+                for (std::size_t i = 0; i < n->neighbours.size(); ++i) {
+                    // Blocked edges can't be used as transitions.
+                    if (cluster_of(n->neighbours[i]) == d && n->costs[i] != infinity) crossings.push_back(crossing { n, n->neighbours[i], n->costs[i] });
+                }
+            }
+            
+            if (crossings.empty()) return;
+            
+            
+            // Crossing edges form a single entrance if their nodes in c are connected to each other through other crossing nodes.
+            std::unordered_map<std::uint32_t, std::uint32_t> entrance_of;
+            for (const auto& x : crossings) entrance_of.emplace(std::uint32_t(x.inside->id), no_node);
+            
+            std::uint32_t entrances = 0;
+            
+            for (auto& [start, entrance] : entrance_of) {
+                if (entrance != no_node) continue;
+                
+                std::vector<std::uint32_t> stack { start };
+                entrance = entrances;
+                
+                while (!stack.empty()) {
+                    const node* n = g->nodes[stack.back()].get();
+                    stack.pop_back();
+                    
+                    for (const node* neighbour : n->neighbours) {
+                        auto it = entrance_of.find(std::uint32_t(neighbour->id));
+                        if (it == entrance_of.end() || it->second != no_node) continue;
+                        
+                        it->second = entrances;
+                        stack.push_back(it->first);
+                    }
+                }
+                
+                ++entrances;
+            }
+            
+            
+            // Order the crossings of each entrance along the border, so the middle and both ends can be picked.
+            auto position_order = [](const node* a, const node* b) {
+                return a->position.x != b->position.x ? a->position.x < b->position.x : a->position.y < b->position.y;
+            };
+            
+            std::sort(crossings.begin(), crossings.end(), [&](const crossing& a, const crossing& b) {
+                std::uint32_t ea = entrance_of[std::uint32_t(a.inside->id)], eb = entrance_of[std::uint32_t(b.inside->id)];
+                if (ea != eb) return ea < eb;
+                
+                if (a.inside != b.inside) return position_order(a.inside, b.inside);
+                return position_order(a.outside, b.outside);
+            });
+            
+            
+            auto add = [&](const crossing& x) {
+                clusters[c].transitions.push_back(transition { std::uint32_t(x.inside->id), std::uint32_t(x.outside->id), x.cost, d });
+                clusters[d].transitions.push_back(transition { std::uint32_t(x.outside->id), std::uint32_t(x.inside->id), x.cost, c });
+            };
+            
+            for (std::size_t begin = 0; begin < crossings.size(); ) {
+                std::size_t end = begin;
+                const std::uint32_t entrance = entrance_of[std::uint32_t(crossings[begin].inside->id)];
+                
+                while (end < crossings.size() && entrance_of[std::uint32_t(crossings[end].inside->id)] == entrance) ++end;
+                
+                
+                if (end - begin >= long_entrance) {
+                    add(crossings[begin]);
+                    add(crossings[end - 1]);
+                } else {
+                    add(crossings[begin + (end - begin) / 2]);
+                }
+                
+                begin = end;
+            }
+        }
+        
+        
+        // Recomputes the entrance nodes of cluster c from its transitions, and the costs between them.
+        void compute_entrances(std::uint32_t c) {
+            auto& cl = clusters[c];
+            
+            cl.entrances.clear();
+            for (const auto& t : cl.transitions) cl.entrances.push_back(t.from);
+            
+            std::sort(cl.entrances.begin(), cl.entrances.end());
+            cl.entrances.erase(std::unique(cl.entrances.begin(), cl.entrances.end()), cl.entrances.end());
+            
+            
+            const std::size_t count = cl.entrances.size();
+            cl.distances.assign(count * count, infinity);
+            
+            for (std::size_t i = 0; i < count; ++i) {
+                local_search(c, g->nodes[cl.entrances[i]].get());
+                
+                for (std::size_t j = 0; j < count; ++j) {
+                    cl.distances[i * count + j] = scratch.distance[local_index[cl.entrances[j]]];
+                }
+            }
+        }
+    };
+    
+    
+    inline std::vector<node*> hierarchical_path::refine_segment(std::size_t i) const {
+        return owner->refine_segment(waypoints[i], waypoints[i + 1]);
+    }
+    
+    
+    inline std::vector<node*> hierarchical_path::refine(void) const {
+        if (waypoints.size() == 1) return waypoints;
+        
+        std::vector<node*> result;
+        
+        for (std::size_t i = 0; i < segment_count(); ++i) {
+            auto segment = refine_segment(i);
+            
+            // Consecutive segments share a waypoint.
+            result.insert(result.end(), segment.begin() + (result.empty() ? 0 : 1), segment.end());
+        }
+        
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/grid_map.hpp>
+#include <imperative/search_workspace.hpp>
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+
+
+namespace imp {
+    namespace detail {
+        // The 8 grid directions. Straight directions come first, so a direction d is diagonal iff d >= 4.
+        constexpr inline std::array<vec2i, 8> grid_directions {
+            vec2i { 1, 0 }, vec2i { -1, 0 }, vec2i { 0, 1 }, vec2i { 0, -1 },
+            vec2i { 1, 1 }, vec2i { -1, 1 }, vec2i { 1, -1 }, vec2i { -1, -1 }
+        };
+        
+        
+        constexpr inline unsigned grid_direction_index(int dx, int dy) {
+            if (!dy) return dx > 0 ? 0 : 1;
+            if (!dx) return dy > 0 ? 2 : 3;
+            return 4 + (dx < 0) + 2 * (dy < 0);
+        }
+        
+        
+        // Exact cost of a straight or diagonal segment on the grid, and an admissible heuristic for any pair of cells.
+        inline float octile_distance(vec2i a, vec2i b) {
+            const int dx = std::abs(a.x - b.x), dy = std::abs(a.y - b.y);
+            return float(std::max(dx, dy)) + (std::sqrt(2.0f) - 1.0f) * float(std::min(dx, dy));
+        }
+        
+        
+        inline int sign(int v) {
+            return (v > 0) - (v < 0);
+        }
+        
+        
+        // Directions to explore from a cell reached by moving in direction (dx, dy), as a bitmask over grid_directions.
+        // Directions that are blocked are removed by the jump itself, so this only contains the natural and potentially forced neighbours.
+        inline unsigned pruned_directions(int dx, int dy) {
+            auto bit = [](int x, int y) { return 1u << grid_direction_index(x, y); };
+            
+            if (dx && dy) return bit(dx, 0) | bit(0, dy) | bit(dx, dy);
+            if (dx) return bit(dx, 0) | bit(dx, 1) | bit(dx, -1) | bit(0, 1) | bit(0, -1);
+            return bit(0, dy) | bit(1, dy) | bit(-1, dy) | bit(1, 0) | bit(-1, 0);
+        }
+        
+        
+        // A cell reached by a straight move is a jump point if one of the cells beside it can only be reached optimally through it,
+        // i.e. the side cell is open, but the cell diagonally behind it is blocked.
+        inline bool has_forced_neighbour(const grid_map& grid, std::size_t cell, std::ptrdiff_t step, std::ptrdiff_t side) {
+            return (grid.is_open(cell + side) && !grid.is_open(cell + side - step)) ||
+                   (grid.is_open(cell - side) && !grid.is_open(cell - side - step));
+        }
+        
+        
+        inline std::size_t jump_straight(const grid_map& grid, std::size_t cell, std::ptrdiff_t step, std::ptrdiff_t side, std::size_t goal) {
+            while (true) {
+                cell += step;
+                
+                if (!grid.is_open(cell)) return grid_map::no_cell;
+                if (cell == goal || has_forced_neighbour(grid, cell, step, side)) return cell;
+            }
+        }
+        
+        
+        // A cell reached by a diagonal move is a jump point if a straight jump in either of its components finds one.
+        inline std::size_t jump_diagonal(const grid_map& grid, std::size_t cell, std::ptrdiff_t horizontal, std::ptrdiff_t vertical, std::size_t goal) {
+            const std::ptrdiff_t stride = std::ptrdiff_t(grid.get_stride());
+            
+            while (true) {
+                if (!grid.is_open(cell + horizontal) || !grid.is_open(cell + vertical) || !grid.is_open(cell + horizontal + vertical)) {
+                    return grid_map::no_cell;
+                }
+                
+                cell += horizontal + vertical;
+                if (cell == goal) return cell;
+                
+                if (jump_straight(grid, cell, horizontal, stride, goal) != grid_map::no_cell) return cell;
+                if (jump_straight(grid, cell, vertical, 1, goal) != grid_map::no_cell) return cell;
+            }
+        }
+        
+        
+        // Converts the jump points found by the search back to a path through every cell in between.
+        template <typename OpenSet>
+        inline std::vector<node*> expand_jump_path(const grid_map& grid, const basic_search_workspace<OpenSet>& ws, std::size_t goal) {
+            const auto jump_points = ws.path_to(goal);
+            std::vector<node*> result { grid.node_at(jump_points.front()) };
+            
+            for (std::size_t i = 1; i < jump_points.size(); ++i) {
+                const vec2i from = grid.coordinates(jump_points[i - 1]), to = grid.coordinates(jump_points[i]);
+                const std::ptrdiff_t step = sign(to.x - from.x) + sign(to.y - from.y) * std::ptrdiff_t(grid.get_stride());
+                
+                for (std::size_t cell = jump_points[i - 1]; cell != jump_points[i]; ) {
+                    cell += step;
+                    result.push_back(grid.node_at(cell));
+                }
+            }
+            
+            return result;
+        }
+        
+        
+        // Shared search loop for JPS and JPS+. successors is invoked with a cell, the bitmask of directions to explore from it
+        // and a callback that should be invoked with every jump point found in those directions.
+        template <typename OpenSet, typename Successors>
+        inline std::vector<node*> jump_point_search_impl(const grid_map& grid, node* from, node* to, Successors&& successors, basic_search_workspace<OpenSet>& ws) {
+            using ws_type = basic_search_workspace<OpenSet>;
+            
+            
+            const std::size_t start = grid.cell_of(from), goal = grid.cell_of(to);
+            if (start == grid_map::no_cell || goal == grid_map::no_cell) return {};
+            
+            const vec2i target = grid.coordinates(goal);
+            
+            
+            ws.begin_query(grid.cell_count());
+            ws.visit(start, 0, ws_type::no_parent);
+            ws.open.push_or_update(start, octile_distance(grid.coordinates(start), target));
+            
+            
+            while (!ws.open.empty()) {
+                const std::size_t current = ws.open.pop();
+                if (current == goal) return expand_jump_path(grid, ws, goal);
+                
+                const vec2i position = grid.coordinates(current);
+                const float current_gscore = ws.gscore(current);
+                
+                
+                // The start cell explores every direction, every other cell only continues the move that reached it.
+                unsigned directions = 0xFF;
+                
+                if (std::uint32_t parent = ws.came_from(current); parent != ws_type::no_parent) {
+                    const vec2i p = grid.coordinates(parent);
+                    directions = pruned_directions(sign(position.x - p.x), sign(position.y - p.y));
+                }
+                
+                
+                successors(current, directions, [&](std::size_t successor) {
+                    const vec2i q = grid.coordinates(successor);
+                    float tentative_gscore = current_gscore + octile_distance(position, q);
+                    
+                    if (tentative_gscore < ws.gscore(successor)) {
+                        ws.visit(successor, tentative_gscore, std::uint32_t(current));
+                        ws.open.push_or_update(successor, tentative_gscore + octile_distance(q, target));
+                    }
+                });
+            }
+            
+            
+            return {};
+        }
+    }
+    
+    
+    // Precomputed jump distances for JPS+. For every open cell and direction the table stores the number of steps to the next jump point
+    // in that direction if it is positive, or minus the number of steps that can be taken before hitting an obstacle otherwise.
+    // The table is only valid as long as the grid it was built from does not change.
+    class jps_plus_table {
+    public:
+        jps_plus_table(void) = default;
+        
+        
+        static jps_plus_table build(const grid_map& grid) {
+            jps_plus_table result;
+            result.grid = &grid;
+            result.distances.resize(grid.cell_count(), {});
+            
+            const std::ptrdiff_t stride = std::ptrdiff_t(grid.get_stride());
+            
+            
+            auto step_of = [&](unsigned d) {
+                return detail::grid_directions[d].x + detail::grid_directions[d].y * stride;
+            };
+            
+            // Distances depend on the distance of the next cell in the same direction, so cells are visited in the opposite order.
+            auto for_each_cell = [&](std::ptrdiff_t step, auto&& fn) {
+                if (step > 0) {
+                    for (std::size_t cell = grid.cell_count(); cell-- > 0; ) if (grid.is_open(cell)) fn(cell);
+                } else {
+                    for (std::size_t cell = 0; cell < grid.cell_count(); ++cell) if (grid.is_open(cell)) fn(cell);
+                }
+            };
+            
+            auto extend = [](std::int32_t next) {
+                return next > 0 ? next + 1 : next - 1;
+            };
+            
+            
+            for (unsigned d = 0; d < 4; ++d) {
+                const std::ptrdiff_t step = step_of(d);
+                const std::ptrdiff_t side = detail::grid_directions[d].x ? stride : 1;
+                
+                for_each_cell(step, [&](std::size_t cell) {
+                    const std::size_t next = cell + step;
+                    auto& distance = result.distances[cell][d];
+                    
+                    if (!grid.is_open(next)) distance = 0;
+                    else if (detail::has_forced_neighbour(grid, next, step, side)) distance = 1;
+                    else distance = extend(result.distances[next][d]);
+                });
+            }
+            
+            
+            for (unsigned d = 4; d < 8; ++d) {
+                const std::ptrdiff_t horizontal = detail::grid_directions[d].x;
+                const std::ptrdiff_t vertical   = detail::grid_directions[d].y * stride;
+                
+                const unsigned horizontal_direction = detail::grid_direction_index(detail::grid_directions[d].x, 0);
+                const unsigned vertical_direction   = detail::grid_direction_index(0, detail::grid_directions[d].y);
+                
+                for_each_cell(horizontal + vertical, [&](std::size_t cell) {
+                    const std::size_t next = cell + horizontal + vertical;
+                    auto& distance = result.distances[cell][d];
+                    
+                    if (!grid.is_open(cell + horizontal) || !grid.is_open(cell + vertical) || !grid.is_open(next)) distance = 0;
+                    else if (result.distances[next][horizontal_direction] > 0 || result.distances[next][vertical_direction] > 0) distance = 1;
+                    else distance = extend(result.distances[next][d]);
+                });
+            }
+            
+            
+            return result;
+        }
+        
+        
+        const grid_map& get_grid(void) const { return *grid; }
+        
+        std::int32_t distance(std::size_t cell, unsigned direction) const {
+            return distances[cell][direction];
+        }
+    private:
+        const grid_map* grid = nullptr;
+        std::vector<std::array<std::int32_t, 8>> distances;
+    };
+    
+    
+    // Jump point search over a uniform-cost grid (see grid_map::create and grid_map::detect).
+    // Returns the same paths as A_star on the underlying graph, including every node in between jump points,
+    // but only expands the jump points themselves. Returns an empty path if either node is not part of the grid.
+    template <typename OpenSet>
+    inline std::vector<node*> jump_point_search(const grid_map& grid, node* from, node* to, basic_search_workspace<OpenSet>& ws) {
+        const std::size_t goal = grid.cell_of(to);
+        const std::ptrdiff_t stride = std::ptrdiff_t(grid.get_stride());
+        
+        auto successors = [&](std::size_t cell, unsigned directions, auto&& emit) {
+            for (unsigned d = 0; d < 8; ++d) {
+                if (!(directions & (1u << d))) continue;
+                
+                const std::ptrdiff_t horizontal = detail::grid_directions[d].x;
+                const std::ptrdiff_t vertical   = detail::grid_directions[d].y * stride;
+                
+                std::size_t jump_point = grid_map::no_cell;
+                if (d >= 4) jump_point = detail::jump_diagonal(grid, cell, horizontal, vertical, goal);
+                else if (horizontal) jump_point = detail::jump_straight(grid, cell, horizontal, stride, goal);
+                else jump_point = detail::jump_straight(grid, cell, vertical, 1, goal);
+                
+                if (jump_point != grid_map::no_cell) emit(jump_point);
+            }
+        };
+        
+        return detail::jump_point_search_impl(grid, from, to, successors, ws);
+    }
+    
+    
+    // JPS+: the same search, but every jump is a single lookup in the precomputed table.
+    template <typename OpenSet>
+    inline std::vector<node*> jump_point_search(const jps_plus_table& table, node* from, node* to, basic_search_workspace<OpenSet>& ws) {
+        const grid_map& grid = table.get_grid();
+        
+        const std::size_t goal = grid.cell_of(to);
+        if (goal == grid_map::no_cell) return {};
+        
+        const vec2i target = grid.coordinates(goal);
+        const std::ptrdiff_t stride = std::ptrdiff_t(grid.get_stride());
+        
+        
+        auto successors = [&](std::size_t cell, unsigned directions, auto&& emit) {
+            const vec2i position = grid.coordinates(cell);
+            const int to_x = target.x - position.x, to_y = target.y - position.y;
+            
+            for (unsigned d = 0; d < 8; ++d) {
+                if (!(directions & (1u << d))) continue;
+                
+                const vec2i dir = detail::grid_directions[d];
+                const std::int32_t distance = table.distance(cell, d);
+                const int reach = std::abs(distance);
+                
+                const std::ptrdiff_t step = dir.x + dir.y * stride;
+                
+                
+                // The table doesn't know about the goal, so check if it can be reached in this direction before the next jump point.
+                // For diagonal moves, stop at the cell in line with the goal; the straight jump from there will find it.
+                int goal_steps = 0;
+                
+                if (d < 4) {
+                    bool in_line = dir.x ? (to_y == 0 && detail::sign(to_x) == dir.x) : (to_x == 0 && detail::sign(to_y) == dir.y);
+                    if (in_line) goal_steps = std::abs(to_x + to_y);
+                } else if (detail::sign(to_x) == dir.x && detail::sign(to_y) == dir.y) {
+                    goal_steps = std::min(std::abs(to_x), std::abs(to_y));
+                }
+                
+                
+                if (goal_steps > 0 && goal_steps <= reach) emit(cell + goal_steps * step);
+                else if (distance > 0) emit(cell + distance * step);
+            }
+        };
+        
+        return detail::jump_point_search_impl(grid, from, to, successors, ws);
+    }
+    
+    
+    template <typename Grid>
+    inline std::vector<node*> jump_point_search(const Grid& grid, node* from, node* to) {
+        search_workspace ws;
+        return jump_point_search(grid, from, to, ws);
+    }
+}
\ No newline at end of file
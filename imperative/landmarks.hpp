@@ -0,0 +1,274 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/cost_function.hpp>
+#include <imperative/dijkstra.hpp>
+#include <imperative/binary_io.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+
+namespace imp {
+    enum class landmark_selection {
+        // Each landmark is the node furthest away from all previously selected landmarks.
+        farthest,
+        // Goldberg & Werneck's avoid heuristic: landmarks are placed in regions where the current lower bounds are poor.
+        avoid
+    };
+    
+    
+    // Distance tables for the ALT (A*, Landmarks, Triangle inequality) heuristic.
+    // For every node v and landmark L the table stores d(L, v). Since graph edges are undirected,
+    // |d(L, t) - d(L, v)| is a lower bound on d(v, t) for every landmark.
+    //
+    // Distances are stored node-major, so evaluating the heuristic for a node reads a single contiguous block.
+    class landmark_table {
+    public:
+        landmark_table(void) = default;
+        
+        
+        // Selects count landmarks in g and computes their distance tables.
+        // Selection is sequential, since every landmark depends on the distances of the previous ones,
+        // but the search for the next avoid root runs concurrently with the table of the previous landmark.
+        static landmark_table build(const graph& g, std::size_t count, landmark_selection selection = landmark_selection::avoid, unsigned seed = 0) {
+            count = std::min(count, g.nodes.size());
+            
+            std::vector<std::uint32_t> landmarks;
+            std::vector<std::vector<float>> rows;
+            
+            if (selection == landmark_selection::farthest) select_farthest(g, count, landmarks, rows);
+            else select_avoid(g, count, seed, landmarks, rows);
+            
+            return landmark_table { g.nodes.size(), std::move(landmarks), rows };
+        }
+        
+        
+        // Computes the distance tables for the given landmarks, running one Dijkstra per landmark across threads.
+        // This can be used to update the tables after edge costs have changed, without selecting new landmarks.
+        static landmark_table build(const graph& g, std::vector<std::uint32_t> landmarks, unsigned threads = std::thread::hardware_concurrency()) {
+            std::vector<std::vector<float>> rows(landmarks.size());
+            std::atomic<std::size_t> next = 0;
+            
+            auto worker = [&] {
+                for (std::size_t i = next++; i < landmarks.size(); i = next++) {
+                    rows[i] = dijkstra(g, g.nodes[landmarks[i]].get()).distance;
+                }
+            };
+            
+            std::vector<std::jthread> workers;
+            for (unsigned i = 1; i < std::max(threads, 1u); ++i) workers.emplace_back(worker);
+            worker();
+            workers.clear();
+            
+            return landmark_table { g.nodes.size(), std::move(landmarks), rows };
+        }
+        
+        
+        // Lower bound on the distance between the nodes with the given IDs.
+        float lower_bound(std::size_t a, std::size_t b) const {
+            if (landmarks.empty()) return 0;
+            
+            const float* da = &distances[a * landmarks.size()];
+            const float* db = &distances[b * landmarks.size()];
+            
+            float result = 0;
+            
+            for (std::size_t k = 0; k < landmarks.size(); ++k) {
+                // Nodes that cannot reach a landmark don't provide a bound.
+                float bound = std::abs(da[k] - db[k]);
+                if (std::isfinite(bound)) result = std::max(result, bound);
+            }
+            
+            return result;
+        }
+        
+        
+        std::size_t node_count(void) const { return nodes; }
+        const std::vector<std::uint32_t>& get_landmarks(void) const { return landmarks; }
+        
+        bool compatible_with(const graph& g) const {
+            return nodes == g.nodes.size();
+        }
+        
+        
+        // Binary format (native endianness):
+        // char[8]      magic ("FP2ALT" followed by two null bytes)
+        // uint32       format version
+        // uint32       landmark count K
+        // uint64       node count N
+        // uint32[K]    landmark node IDs
+        // float[N * K] distances, node-major
+        void save(const std::string& path) const {
+            std::ofstream stream { path, std::ios::binary };
+            if (!stream) throw std::runtime_error { "Failed to open landmark file for writing: " + path };
+            
+            binary_io::write_header(stream, file_magic, file_version);
+            binary_io::write(stream, std::uint32_t(landmarks.size()));
+            binary_io::write(stream, std::uint64_t(nodes));
+            binary_io::write(stream, landmarks.data(), landmarks.size());
+            binary_io::write(stream, distances.data(), distances.size());
+            
+            if (!stream) throw std::runtime_error { "Failed to write landmark file: " + path };
+        }
+        
+        
+        static landmark_table load(const std::string& path) {
+            std::ifstream stream { path, std::ios::binary };
+            if (!stream) throw std::runtime_error { "Failed to open landmark file: " + path };
+            
+            binary_io::read_header(stream, file_magic, file_version, path);
+            
+            landmark_table result;
+            result.landmarks.resize(binary_io::read<std::uint32_t>(stream));
+            result.nodes = std::size_t(binary_io::read<std::uint64_t>(stream));
+            result.distances.resize(result.nodes * result.landmarks.size());
+            
+            binary_io::read(stream, result.landmarks.data(), result.landmarks.size());
+            binary_io::read(stream, result.distances.data(), result.distances.size());
+            
+            if (!stream) throw std::runtime_error { "Landmark file is truncated: " + path };
+            return result;
+        }
+    private:
+        constexpr static char file_magic[8] = { 'F', 'P', '2', 'A', 'L', 'T', '\0', '\0' };
+        constexpr static std::uint32_t file_version = 1;
+        
+        std::size_t nodes = 0;
+        std::vector<std::uint32_t> landmarks;
+        std::vector<float> distances;
+        
+        
+        landmark_table(std::size_t nodes, std::vector<std::uint32_t>&& landmarks, const std::vector<std::vector<float>>& rows) :
+            nodes(nodes),
+            landmarks(std::move(landmarks)),
+            distances(nodes * rows.size())
+        {
+            // Rows are computed per landmark but stored per node.
+            for (std::size_t k = 0; k < rows.size(); ++k) {
+                for (std::size_t v = 0; v < nodes; ++v) distances[v * rows.size() + k] = rows[k][v];
+            }
+        }
+        
+        
+        static void select_farthest(const graph& g, std::size_t count, std::vector<std::uint32_t>& landmarks, std::vector<std::vector<float>>& rows) {
+            if (count == 0) return;
+            
+            // The first landmark is the node furthest away from an arbitrary node.
+            // Every next landmark is the node with the largest distance to its nearest landmark.
+            std::vector<float> nearest = dijkstra(g, g.nodes.front().get()).distance;
+            
+            while (landmarks.size() < count) {
+                std::uint32_t best = 0;
+                
+                for (std::uint32_t v = 0; v < nearest.size(); ++v) {
+                    // Unreachable nodes are skipped, but still preferred over picking the same landmark twice.
+                    bool better = std::isfinite(nearest[v]) && (!std::isfinite(nearest[best]) || nearest[v] > nearest[best]);
+                    if (better) best = v;
+                }
+                
+                if (nearest[best] == 0) break;
+                
+                landmarks.push_back(best);
+                rows.push_back(dijkstra(g, g.nodes[best].get()).distance);
+                
+                // After the first landmark, only distances to landmarks matter.
+                if (landmarks.size() == 1) nearest = rows.back();
+                else for (std::size_t v = 0; v < nearest.size(); ++v) nearest[v] = std::min(nearest[v], rows.back()[v]);
+            }
+        }
+        
+        
+        static void select_avoid(const graph& g, std::size_t count, unsigned seed, std::vector<std::uint32_t>& landmarks, std::vector<std::vector<float>>& rows) {
+            std::mt19937 rng { seed };
+            std::uniform_int_distribution<std::size_t> pick { 0, g.nodes.empty() ? 0 : g.nodes.size() - 1 };
+            
+            auto row_of = [&](std::uint32_t landmark) {
+                return std::async(std::launch::async, [&g, landmark] { return dijkstra(g, g.nodes[landmark].get()).distance; });
+            };
+            
+            std::future<std::vector<float>> pending;
+            
+            
+            for (std::size_t attempt = 0; landmarks.size() < count && attempt < 4 * count; ++attempt) {
+                const std::uint32_t root = std::uint32_t(pick(rng));
+                shortest_path_tree tree = dijkstra(g, g.nodes[root].get());
+                
+                if (pending.valid()) rows.push_back(pending.get());
+                
+                
+                // weight(v) = d(root, v) - LB(root, v): how much the current landmarks underestimate the distance to v.
+                // The size of a subtree is the sum of its weights, or zero if it contains a landmark.
+                std::vector<float> size(g.nodes.size(), 0);
+                std::vector<bool> is_landmark(g.nodes.size(), false), has_landmark(g.nodes.size(), false);
+                
+                for (auto l : landmarks) is_landmark[l] = has_landmark[l] = true;
+                
+                
+                for (auto it = tree.order.rbegin(); it != tree.order.rend(); ++it) {
+                    std::uint32_t v = *it;
+                    
+                    float lower_bound = 0;
+                    for (const auto& row : rows) {
+                        float bound = std::abs(row[v] - row[root]);
+                        if (std::isfinite(bound)) lower_bound = std::max(lower_bound, bound);
+                    }
+                    
+                    if (has_landmark[v]) size[v] = 0;
+                    else size[v] += std::max(tree.distance[v] - lower_bound, 0.0f);
+                    
+                    std::uint32_t parent = tree.parent[v];
+                    if (parent == shortest_path_tree::no_parent) continue;
+                    
+                    if (has_landmark[v]) has_landmark[parent] = true;
+                    else size[parent] += size[v];
+                }
+                
+                
+                // Descend from the root, always into the child with the largest subtree, until a leaf is reached.
+                std::vector<std::uint32_t> best_child(g.nodes.size(), shortest_path_tree::no_parent);
+                
+                for (std::uint32_t v : tree.order) {
+                    std::uint32_t parent = tree.parent[v];
+                    if (parent == shortest_path_tree::no_parent || size[v] <= 0) continue;
+                    
+                    auto& best = best_child[parent];
+                    if (best == shortest_path_tree::no_parent || size[v] > size[best]) best = v;
+                }
+                
+                std::uint32_t leaf = root;
+                while (best_child[leaf] != shortest_path_tree::no_parent) leaf = best_child[leaf];
+                
+                if (is_landmark[leaf]) continue;
+                
+                
+                landmarks.push_back(leaf);
+                pending = row_of(leaf);
+            }
+            
+            
+            if (pending.valid()) rows.push_back(pending.get());
+        }
+    };
+    
+    
+    // ALT heuristic: the largest lower bound given by the triangle inequality over all landmarks.
+    struct landmark_cost final : public cost_function {
+        const landmark_table* table;
+        
+        explicit landmark_cost(const landmark_table& table) : table(&table) {}
+        
+        float cost(const node* a, const node* b) override {
+            return table->lower_bound(a->id, b->id);
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <cstddef>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+namespace imp {
+    // Read-only memory mapping of an entire file. Pages are loaded by the OS when they are first accessed,
+    // so opening a file takes the same time regardless of its size, and unused parts of it are never read.
+    // The mapping stays valid when this object is moved, so pointers into it can be stored alongside it.
+    class mapped_file {
+    public:
+        mapped_file(void) = default;
+        
+        
+        explicit mapped_file(const std::string& path) {
+            #if defined(_WIN32)
+                HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) throw std::runtime_error { "Failed to open file: " + path };
+                
+                LARGE_INTEGER file_size;
+                if (!GetFileSizeEx(file, &file_size)) {
+                    CloseHandle(file);
+                    throw std::runtime_error { "Failed to get the size of file: " + path };
+                }
+                
+                length = std::size_t(file_size.QuadPart);
+                
+                
+                // Empty files can't be mapped, but they also don't need to be.
+                if (length > 0) {
+                    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                    if (mapping) address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    
+                    // The view keeps the file mapped after both handles are closed.
+                    if (mapping) CloseHandle(mapping);
+                    CloseHandle(file);
+                    
+                    if (!address) throw std::runtime_error { "Failed to map file: " + path };
+                } else {
+                    CloseHandle(file);
+                }
+            #else
+                int file = ::open(path.c_str(), O_RDONLY);
+                if (file == -1) throw std::runtime_error { "Failed to open file: " + path };
+                
+                struct stat info;
+                if (::fstat(file, &info) == -1) {
+                    ::close(file);
+                    throw std::runtime_error { "Failed to get the size of file: " + path };
+                }
+                
+                length = std::size_t(info.st_size);
+                
+                
+                // Empty files can't be mapped, but they also don't need to be.
+                if (length > 0) {
+                    void* result = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0);
+                    
+                    // The mapping keeps the file open after the descriptor is closed.
+                    ::close(file);
+                    
+                    if (result == MAP_FAILED) throw std::runtime_error { "Failed to map file: " + path };
+                    address = result;
+                } else {
+                    ::close(file);
+                }
+            #endif
+        }
+        
+        
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        
+        
+        mapped_file(mapped_file&& other) noexcept :
+            address(std::exchange(other.address, nullptr)),
+            length(std::exchange(other.length, 0))
+        {}
+        
+        
+        mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+                unmap();
+                
+                address = std::exchange(other.address, nullptr);
+                length  = std::exchange(other.length, 0);
+            }
+            
+            return *this;
+        }
+        
+        
+        ~mapped_file(void) {
+            unmap();
+        }
+        
+        
+        const std::byte* data(void) const { return static_cast<const std::byte*>(address); }
+        std::size_t size(void) const { return length; }
+    private:
+        void* address = nullptr;
+        std::size_t length = 0;
+        
+        
+        void unmap(void) {
+            if (!address) return;
+            
+            #if defined(_WIN32)
+                UnmapViewOfFile(address);
+            #else
+                ::munmap(address, length);
+            #endif
+            
+            address = nullptr;
+            length  = 0;
+        }
+    };
+}
\ No newline at end of file
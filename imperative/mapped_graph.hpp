@@ -0,0 +1,268 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/common.hpp>
+#include <imperative/csr_graph.hpp>
+#include <imperative/mapped_file.hpp>
+#include <imperative/binary_io.hpp>
+
+#include <vector>
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Compressed sparse row graph stored in a memory mapped file, laid out exactly as it is used in memory.
+    // Loading a graph only maps the file and checks its header, so startup time doesn't depend on the size of the graph,
+    // and the pages of the file are shared between every process that maps it.
+    // Provides the same accessors as csr_graph, so it can be searched in place with the CSR overloads of A_star.
+    //
+    // Only the header and the bounds of every section are checked when loading.
+    // The contents of the sections are trusted, so files must only be loaded from trusted sources.
+    class mapped_graph {
+    public:
+        using id_type = csr_graph::id_type;
+        constexpr static id_type invalid_id = csr_graph::invalid_id;
+        
+        
+        // Every section starts at a multiple of this, so sections are page-aligned on every common platform.
+        constexpr static std::size_t section_alignment = 4096;
+        
+        
+        mapped_graph(void) = default;
+        
+        
+        std::size_t node_count(void) const { return xs.size(); }
+        std::size_t edge_count(void) const { return targets.size(); }
+        
+        
+        std::span<const id_type> neighbours(id_type id) const {
+            return targets.subspan(offsets[id], offsets[id + 1] - offsets[id]);
+        }
+        
+        std::span<const float> costs(id_type id) const {
+            return weights.subspan(offsets[id], offsets[id + 1] - offsets[id]);
+        }
+        
+        vec2i position(id_type id) const {
+            return { xs[id], ys[id] };
+        }
+        
+        
+        std::string_view name(id_type id) const {
+            return std::string_view { names.data() + name_offsets[id], std::size_t(name_offsets[id + 1] - name_offsets[id]) };
+        }
+        
+        
+        // Size of the mapped file in bytes. Only the pages that are actually accessed take up physical memory.
+        std::size_t file_size(void) const { return file.size(); }
+        
+        
+        // Binary format (native endianness). The header is followed by the sections, each starting at a multiple of section_alignment:
+        // char[8]          magic ("FP2GRAPH")
+        // uint32           format version
+        // uint32           section alignment
+        // uint64           node count N
+        // uint64           edge count M
+        // uint64           names size S
+        // uint64[7]        file offset of each section, in the order below
+        //
+        // uint64[N + 1]    CSR offsets: the edges of node i are at indices offsets[i] to offsets[i + 1]
+        // uint32[M]        edge targets
+        // float[M]         edge costs
+        // int32[N]         x coordinates
+        // int32[N]         y coordinates
+        // uint64[N + 1]    name offsets: the name of node i is at indices name_offsets[i] to name_offsets[i + 1] of the names blob
+        // char[S]          names blob
+        //
+        // Node IDs are the same as node::id in g. The edge costs stored in g are written.
+        static void save(const graph& g, const std::string& path) {
+            file_header header {};
+            std::memcpy(header.magic, file_magic, sizeof(file_magic));
+            header.version    = file_version;
+            header.alignment  = std::uint32_t(section_alignment);
+            header.node_count = g.nodes.size();
+            
+            for (const auto& n : g.nodes) {
+                header.edge_count += n->neighbours.size();
+                header.names_size += n->name.size();
+            }
+            
+            const auto sizes = section_sizes(header);
+            
+            std::uint64_t position = sizeof(file_header);
+            for (std::size_t s = 0; s < section_count; ++s) {
+                header.sections[s] = align(position);
+                position = header.sections[s] + sizes[s];
+            }
+            
+            
+            std::ofstream stream { path, std::ios::binary };
+            if (!stream) throw std::runtime_error { "Failed to open graph file for writing: " + path };
+            
+            binary_io::write(stream, header);
+            
+            
+            // Sections are written one at a time, so the graph is never copied as a whole.
+            const auto begin_section = [&](section s) {
+                static const std::array<char, section_alignment> padding {};
+                const std::uint64_t current = std::uint64_t(stream.tellp());
+                
+                binary_io::write(stream, padding.data(), std::size_t(header.sections[s] - current));
+            };
+            
+            
+            begin_section(offsets_section);
+            std::uint64_t edges = 0;
+            binary_io::write(stream, edges);
+            
+            for (const auto& n : g.nodes) {
+                edges += n->neighbours.size();
+                binary_io::write(stream, edges);
+            }
+            
+            
+            begin_section(targets_section);
+            for (const auto& n : g.nodes) {
+                for (const node* neighbour : n->neighbours) binary_io::write(stream, id_type(neighbour->id));
+            }
+            
+            
+            begin_section(weights_section);
+            for (const auto& n : g.nodes) binary_io::write(stream, n->costs.data(), n->costs.size());
+            
+            
+            begin_section(xs_section);
+            for (const auto& n : g.nodes) binary_io::write(stream, std::int32_t(n->position.x));
+            
+            begin_section(ys_section);
+            for (const auto& n : g.nodes) binary_io::write(stream, std::int32_t(n->position.y));
+            
+            
+            begin_section(name_offsets_section);
+            std::uint64_t characters = 0;
+            binary_io::write(stream, characters);
+            
+            for (const auto& n : g.nodes) {
+                characters += n->name.size();
+                binary_io::write(stream, characters);
+            }
+            
+            
+            begin_section(names_section);
+            for (const auto& n : g.nodes) binary_io::write(stream, n->name.data(), n->name.size());
+            
+            
+            if (!stream) throw std::runtime_error { "Failed to write graph file: " + path };
+        }
+        
+        
+        static mapped_graph load(const std::string& path) {
+            mapped_graph result;
+            result.file = mapped_file { path };
+            
+            const std::byte* data = result.file.data();
+            const std::size_t size = result.file.size();
+            
+            
+            file_header header;
+            if (size < sizeof(header)) throw std::runtime_error { "Unrecognized file format: " + path };
+            std::memcpy(&header, data, sizeof(header));
+            
+            if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0) throw std::runtime_error { "Unrecognized file format: " + path };
+            if (header.version != file_version) throw std::runtime_error { "Unsupported file version: " + path };
+            if (header.node_count >= invalid_id) throw std::runtime_error { "Graph file has too many nodes: " + path };
+            if (header.edge_count > size || header.names_size > size) throw std::runtime_error { "Graph file is truncated or corrupt: " + path };
+            
+            
+            const auto sizes = section_sizes(header);
+            
+            for (std::size_t s = 0; s < section_count; ++s) {
+                if (header.sections[s] % section_alignment != 0 || header.sections[s] > size || sizes[s] > size - header.sections[s]) {
+                    throw std::runtime_error { "Graph file is truncated or corrupt: " + path };
+                }
+            }
+            
+            
+            const std::uint64_t n = header.node_count, m = header.edge_count;
+            
+            result.offsets      = get_section<std::uint64_t>(data, header, offsets_section, n + 1);
+            result.targets      = get_section<id_type>(data, header, targets_section, m);
+            result.weights      = get_section<float>(data, header, weights_section, m);
+            result.xs           = get_section<std::int32_t>(data, header, xs_section, n);
+            result.ys           = get_section<std::int32_t>(data, header, ys_section, n);
+            result.name_offsets = get_section<std::uint64_t>(data, header, name_offsets_section, n + 1);
+            result.names        = get_section<char>(data, header, names_section, header.names_size);
+            
+            if (result.offsets[n] != m || result.name_offsets[n] != header.names_size) {
+                throw std::runtime_error { "Graph file is truncated or corrupt: " + path };
+            }
+            
+            
+            return result;
+        }
+    private:
+        enum section : std::size_t {
+            offsets_section, targets_section, weights_section, xs_section, ys_section, name_offsets_section, names_section, section_count
+        };
+        
+        
+        struct file_header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t alignment;
+            std::uint64_t node_count;
+            std::uint64_t edge_count;
+            std::uint64_t names_size;
+            std::array<std::uint64_t, section_count> sections;
+        };
+        
+        
+        constexpr static char file_magic[8] = { 'F', 'P', '2', 'G', 'R', 'A', 'P', 'H' };
+        constexpr static std::uint32_t file_version = 1;
+        
+        
+        mapped_file file;
+        
+        std::span<const std::uint64_t> offsets;
+        std::span<const id_type> targets;
+        std::span<const float> weights;
+        std::span<const std::int32_t> xs, ys;
+        
+        std::span<const std::uint64_t> name_offsets;
+        std::span<const char> names;
+        
+        
+        static std::uint64_t align(std::uint64_t position) {
+            return (position + section_alignment - 1) / section_alignment * section_alignment;
+        }
+        
+        
+        // Size in bytes of every section.
+        static std::array<std::uint64_t, section_count> section_sizes(const file_header& header) {
+            const std::uint64_t n = header.node_count, m = header.edge_count;
+            
+            return {
+                (n + 1) * sizeof(std::uint64_t),
+                m * sizeof(id_type),
+                m * sizeof(float),
+                n * sizeof(std::int32_t),
+                n * sizeof(std::int32_t),
+                (n + 1) * sizeof(std::uint64_t),
+                header.names_size
+            };
+        }
+        
+        
+        template <typename T> static std::span<const T> get_section(const std::byte* data, const file_header& header, section s, std::uint64_t count) {
+            return { reinterpret_cast<const T*>(data + header.sections[s]), std::size_t(count) };
+        }
+    };
+}
\ No newline at end of file
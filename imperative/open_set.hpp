@@ -0,0 +1,407 @@
+#pragma once
+
+#include <imperative/container/indexed_heap.hpp>
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <set>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Open set policies for A_star. Nodes are identified by their dense index (node::id or csr_graph::id_type).
+    // Each policy supports the following operations:
+    // - reset(nodes):                  prepares the open set for a new search over a graph with the given number of nodes.
+    // - empty():                       true if there are no more nodes to expand.
+    // - size():                        the number of nodes in the open set.
+    // - pop():                         removes and returns the node with the lowest fscore.
+    // - min_score():                   the lowest fscore in the open set. The open set must not be empty.
+    // - push_or_update(node, fscore):  inserts the node, or changes its fscore if it is already present.
+    // - memory_usage():                approximate memory used by the open set in bytes.
+    
+    
+    // Indexed 4-ary heap. Fscores are stored inline in the heap,
+    // so comparisons don't require any lookups and updates are true decrease-key operations.
+    class heap_open_set {
+    public:
+        void reset(std::size_t nodes) {
+            heap.clear();
+            heap.reserve_indices(nodes);
+        }
+        
+        
+        bool empty(void) const {
+            return heap.empty();
+        }
+        
+        std::size_t size(void) const {
+            return heap.size();
+        }
+        
+        std::size_t pop(void) {
+            return heap.pop();
+        }
+        
+        float min_score(void) const {
+            return heap.top().key;
+        }
+        
+        void push_or_update(std::size_t n, float fscore) {
+            heap.push_or_update(n, fscore);
+        }
+        
+        std::size_t memory_usage(void) const {
+            return heap.memory_usage();
+        }
+    private:
+        indexed_heap<float, 4> heap;
+    };
+    
+    
+    class score_comparator {
+    public:
+        explicit score_comparator(std::unordered_map<std::size_t, float>* scores) : scores(scores) {}
+        
+        bool operator()(std::size_t a, std::size_t b) const {
+            return scores->at(a) < scores->at(b);
+        }
+    private:
+        std::unordered_map<std::size_t, float>* scores;
+    };
+    
+    
+    // The original open set: a multiset ordered by fscores in a separate hash map.
+    // Kept for comparison with heap_open_set.
+    class multiset_open_set {
+    public:
+        multiset_open_set(void) : discovered(score_comparator { &fscore }) {}
+        
+        // The comparator holds a pointer to fscore, so this object cannot be moved.
+        multiset_open_set(const multiset_open_set&) = delete;
+        multiset_open_set& operator=(const multiset_open_set&) = delete;
+        
+        
+        void reset(std::size_t nodes) {
+            discovered.clear();
+            fscore.clear();
+        }
+        
+        
+        bool empty(void) const {
+            return discovered.empty();
+        }
+        
+        std::size_t size(void) const {
+            return discovered.size();
+        }
+        
+        std::size_t pop(void) {
+            return discovered.extract(discovered.begin()).value();
+        }
+        
+        float min_score(void) const {
+            return fscore.at(*discovered.begin());
+        }
+        
+        void push_or_update(std::size_t n, float fscore) {
+            if (auto it = this->fscore.find(n); it != this->fscore.end()) {
+                // Erasing by key would remove every node with an equal fscore, so find the exact element instead.
+                auto [begin, end] = discovered.equal_range(n);
+                auto elem = std::find(begin, end, n);
+                if (elem != end) discovered.erase(elem);
+                
+                it->second = fscore;
+            } else {
+                this->fscore.emplace(n, fscore);
+            }
+            
+            discovered.insert(n);
+        }
+        
+        
+        // Node based containers don't expose their allocations, so this assumes a tree node has three pointers and a color,
+        // and a hash map node has a next pointer and a cached hash.
+        std::size_t memory_usage(void) const {
+            return discovered.size() * (sizeof(std::size_t) + 4 * sizeof(void*)) +
+                   fscore.size() * (sizeof(std::pair<const std::size_t, float>) + 2 * sizeof(void*)) +
+                   fscore.bucket_count() * sizeof(void*);
+        }
+    private:
+        std::unordered_map<std::size_t, float> fscore;
+        std::multiset<std::size_t, score_comparator> discovered;
+    };
+    
+    
+    namespace detail {
+        // Per-node state shared by the integer open sets, which use lazy deletion: updating a node pushes a new entry,
+        // and entries whose key no longer matches the node's current key are skipped when they come up.
+        // Entries are stamped with the generation of the search that wrote them, so resetting is O(1) rather than O(nodes).
+        class lazy_open_state {
+        public:
+            constexpr static std::uint32_t not_open = std::numeric_limits<std::uint32_t>::max();
+            
+            
+            void reset(std::size_t nodes) {
+                if (states.size() < nodes) states.resize(nodes);
+                
+                if (++generation == 0) {
+                    for (auto& s : states) s = state {};
+                    generation = 1;
+                }
+                
+                live = 0;
+            }
+            
+            
+            std::uint32_t key(std::size_t n) const {
+                return states[n].generation == generation ? states[n].key : not_open;
+            }
+            
+            bool is_current(std::size_t n, std::uint32_t key) const {
+                return key != not_open && this->key(n) == key;
+            }
+            
+            
+            void set_key(std::size_t n, std::uint32_t key) {
+                if (this->key(n) == not_open) ++live;
+                states[n] = state { generation, key };
+            }
+            
+            void close(std::size_t n) {
+                states[n].key = not_open;
+                --live;
+            }
+            
+            
+            bool empty(void) const { return live == 0; }
+            std::size_t size(void) const { return live; }
+            
+            std::size_t memory_usage(void) const { return states.capacity() * sizeof(state); }
+        private:
+            struct state {
+                std::uint32_t generation = 0;
+                std::uint32_t key = not_open;
+            };
+            
+            std::vector<state> states;
+            std::uint32_t generation = 0;
+            std::size_t live = 0;
+        };
+        
+        
+        // Converts an fscore to a fixed-point key with the given number of steps per unit.
+        template <std::uint32_t Scale> inline std::uint32_t fixed_point_key(float fscore) {
+            return std::uint32_t(std::lround(fscore * float(Scale)));
+        }
+    }
+    
+    
+    // Integer open sets. These are monotone priority queues: they require every pushed fscore to be at least the last one popped,
+    // which holds for A* with a consistent heuristic. Keys that are lower anyway are treated as equal to the last popped key.
+    //
+    // Fscores are rounded to multiples of 1 / Scale. With integer edge costs and an integer heuristic (e.g. integer_octile_cost
+    // baked into the graph with graph::bake_costs), the default Scale of 1 is exact. Otherwise a larger Scale gives a fixed-point mode,
+    // where paths can be suboptimal by the rounding error. Keys must fit in 32 bits.
+    
+    
+    // Radix heap (Ahuja, Mehlhorn, Orlin & Tarjan). Entries are kept in buckets by the highest bit in which their key differs
+    // from the last popped key, so every entry moves down at most 32 times before it is popped: O(1) amortized push and O(log C) pop.
+    template <std::uint32_t Scale = 1>
+    class radix_heap_open_set {
+    public:
+        void reset(std::size_t nodes) {
+            state.reset(nodes);
+            for (auto& b : buckets) b.clear();
+            
+            last = 0;
+        }
+        
+        
+        bool empty(void) const {
+            return state.empty();
+        }
+        
+        std::size_t size(void) const {
+            return state.size();
+        }
+        
+        
+        std::size_t pop(void) {
+            settle();
+            
+            const std::size_t result = buckets[0].back().node;
+            buckets[0].pop_back();
+            state.close(result);
+            
+            return result;
+        }
+        
+        
+        float min_score(void) const {
+            settle();
+            return float(last) / float(Scale);
+        }
+        
+        
+        void push_or_update(std::size_t n, float fscore) {
+            const std::uint32_t key = std::max(detail::fixed_point_key<Scale>(fscore), last);
+            if (state.key(n) == key) return;
+            
+            state.set_key(n, key);
+            buckets[bucket_of(key)].push_back(entry { key, std::uint32_t(n) });
+        }
+        
+        
+        std::size_t memory_usage(void) const {
+            std::size_t result = state.memory_usage();
+            for (const auto& b : buckets) result += b.capacity() * sizeof(entry);
+            
+            return result;
+        }
+    private:
+        struct entry {
+            std::uint32_t key, node;
+        };
+        
+        // Bucket 0 holds the keys equal to last, bucket i the keys whose highest bit that differs from last is bit i - 1.
+        // min_score has to drop stale entries to find the minimum, which doesn't change the contents of the open set, hence mutable.
+        mutable std::array<std::vector<entry>, 33> buckets;
+        mutable std::uint32_t last = 0;
+        detail::lazy_open_state state;
+        
+        
+        std::size_t bucket_of(std::uint32_t key) const {
+            return std::size_t(std::bit_width(key ^ last));
+        }
+        
+        
+        // Makes sure the back of bucket 0 is a live entry. The open set must not be empty.
+        void settle(void) const {
+            while (true) {
+                auto& front = buckets[0];
+                while (!front.empty() && !state.is_current(front.back().node, front.back().key)) front.pop_back();
+                
+                if (!front.empty()) return;
+                
+                
+                // Move the lowest key of the first non-empty bucket to last, which redistributes that bucket into lower ones.
+                std::size_t i = 1;
+                while (buckets[i].empty()) ++i;
+                
+                auto& source = buckets[i];
+                last = std::min_element(source.begin(), source.end(), [](const entry& a, const entry& b) { return a.key < b.key; })->key;
+                
+                for (const auto& e : source) {
+                    if (state.is_current(e.node, e.key)) buckets[bucket_of(e.key)].push_back(e);
+                }
+                
+                source.clear();
+            }
+        }
+    };
+    
+    
+    // Dial's bucket queue: one bucket per key in a ring that starts at the last popped key.
+    // Push and pop are O(1), plus a scan over empty buckets proportional to the increase in key, so it works best when the
+    // range of live keys is small, i.e. for small edge costs. The ring grows to fit the largest key in the open set.
+    template <std::uint32_t Scale = 1>
+    class bucket_open_set {
+    public:
+        void reset(std::size_t nodes) {
+            state.reset(nodes);
+            for (auto& b : ring) b.clear();
+            
+            cursor = 0;
+        }
+        
+        
+        bool empty(void) const {
+            return state.empty();
+        }
+        
+        std::size_t size(void) const {
+            return state.size();
+        }
+        
+        
+        std::size_t pop(void) {
+            settle();
+            
+            auto& bucket = ring[cursor & mask()];
+            const std::size_t result = bucket.back();
+            
+            bucket.pop_back();
+            state.close(result);
+            
+            return result;
+        }
+        
+        
+        float min_score(void) const {
+            settle();
+            return float(cursor) / float(Scale);
+        }
+        
+        
+        void push_or_update(std::size_t n, float fscore) {
+            const std::uint32_t key = std::max(detail::fixed_point_key<Scale>(fscore), cursor);
+            if (state.key(n) == key) return;
+            
+            state.set_key(n, key);
+            
+            while (key - cursor >= ring.size()) grow();
+            ring[key & mask()].push_back(std::uint32_t(n));
+        }
+        
+        
+        std::size_t memory_usage(void) const {
+            std::size_t result = state.memory_usage() + ring.capacity() * sizeof(std::vector<std::uint32_t>);
+            for (const auto& b : ring) result += b.capacity() * sizeof(std::uint32_t);
+            
+            return result;
+        }
+    private:
+        // The ring size is a power of two. Bucket (key & mask) holds the entries with that key.
+        // min_score has to skip stale entries and empty buckets, which doesn't change the contents of the open set, hence mutable.
+        mutable std::vector<std::vector<std::uint32_t>> ring = std::vector<std::vector<std::uint32_t>>(64);
+        mutable std::uint32_t cursor = 0;
+        detail::lazy_open_state state;
+        
+        
+        std::size_t mask(void) const {
+            return ring.size() - 1;
+        }
+        
+        
+        // Makes sure the back of the bucket at the cursor is a live entry. The open set must not be empty.
+        void settle(void) const {
+            while (true) {
+                auto& bucket = ring[cursor & mask()];
+                while (!bucket.empty() && !state.is_current(bucket.back(), cursor)) bucket.pop_back();
+                
+                if (!bucket.empty()) return;
+                ++cursor;
+            }
+        }
+        
+        
+        void grow(void) {
+            std::vector<std::vector<std::uint32_t>> old = std::exchange(ring, std::vector<std::vector<std::uint32_t>>(ring.size() * 2));
+            
+            // Stale entries are dropped. A node with several entries is reinserted once per entry, and the extra entries
+            // become stale as soon as the first one is popped.
+            for (auto& bucket : old) {
+                for (std::uint32_t n : bucket) {
+                    if (const std::uint32_t key = state.key(n); key != detail::lazy_open_state::not_open) ring[key & mask()].push_back(n);
+                }
+            }
+        }
+    };
+}
\ No newline at end of file
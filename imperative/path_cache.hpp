@@ -0,0 +1,257 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <optional>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Thread-safe LRU cache of search results, keyed by the start, the goal and an ID for the cost policy used to find the path.
+    // Paths found with different traversal costs (the D of A_star) must use different policy IDs.
+    //
+    // The cache is bounded by the total number of nodes in the stored paths. It is cleared whenever graph::version changes,
+    // i.e. when nodes or edges are added or edge costs change through the methods of graph.
+    //
+    // Every sub-path of a shortest path is itself a shortest path, so a query for two nodes that both lie on a cached path
+    // is answered from that path. Edges of imp::graph are undirected with the same cost both ways, so this includes reversed sub-paths.
+    // This only holds if the cached paths are optimal: don't store the results of suboptimal searches like HPA* or ARA* under the same policy ID.
+    class path_cache {
+    public:
+        using path_ptr = std::shared_ptr<const std::vector<node*>>;
+        
+        
+        struct statistics {
+            std::size_t hits = 0, subpath_hits = 0, misses = 0;
+            // Number of times the cache was cleared because the graph changed.
+            std::size_t invalidations = 0;
+            
+            
+            double hit_rate(void) const {
+                const std::size_t total = hits + subpath_hits + misses;
+                return total ? double(hits + subpath_hits) / total : 0.0;
+            }
+        };
+        
+        
+        explicit path_cache(std::size_t capacity = 1 << 20) : capacity(capacity) {}
+        
+        path_cache(const path_cache&) = delete;
+        path_cache& operator=(const path_cache&) = delete;
+        
+        
+        // Returns the cached path from from to to, or nullptr if it is not cached. An empty path means there is no path.
+        path_ptr find(const graph& g, const node* from, const node* to, std::uint32_t policy = 0) {
+            std::lock_guard lock { mutex };
+            validate(g);
+            
+            if (auto it = entries.find(key { std::uint32_t(from->id), std::uint32_t(to->id), policy }); it != entries.end()) {
+                lru.splice(lru.begin(), lru, it->second);
+                ++stats.hits;
+                
+                return it->second->path;
+            }
+            
+            if (auto path = find_subpath(from, to, policy)) {
+                ++stats.subpath_hits;
+                return insert_locked(from, to, policy, std::move(*path));
+            }
+            
+            ++stats.misses;
+            return nullptr;
+        }
+        
+        
+        // Stores a path found in the current version of g and returns it.
+        path_ptr insert(const graph& g, const node* from, const node* to, std::vector<node*> path, std::uint32_t policy = 0) {
+            std::lock_guard lock { mutex };
+            validate(g);
+            
+            return insert_locked(from, to, policy, std::move(path));
+        }
+        
+        
+        // Returns the cached path if there is one, otherwise invokes search(from, to) and stores its result.
+        // The search runs without holding the lock, so other threads can use the cache in the meantime.
+        template <typename Search>
+        path_ptr find_or_compute(const graph& g, node* from, node* to, Search&& search, std::uint32_t policy = 0) {
+            if (auto path = find(g, from, to, policy)) return path;
+            
+            const std::uint64_t version_before = g.version;
+            std::vector<node*> path = search(from, to);
+            
+            
+            std::lock_guard lock { mutex };
+            validate(g);
+            
+            // The graph changed during the search, so the result can't be cached.
+            if (g.version != version_before) return std::make_shared<const std::vector<node*>>(std::move(path));
+            
+            return insert_locked(from, to, policy, std::move(path));
+        }
+        
+        
+        void clear(void) {
+            std::lock_guard lock { mutex };
+            clear_locked();
+        }
+        
+        
+        statistics get_statistics(void) const {
+            std::lock_guard lock { mutex };
+            return stats;
+        }
+        
+        
+        std::size_t size(void) const {
+            std::lock_guard lock { mutex };
+            return entries.size();
+        }
+    private:
+        struct key {
+            std::uint32_t from, to, policy;
+            bool operator==(const key&) const = default;
+        };
+        
+        struct key_hash {
+            std::size_t operator()(const key& k) const {
+                std::uint64_t h = (std::uint64_t(k.from) << 32 | k.to) * 0x9E3779B97F4A7C15ull;
+                return std::size_t(h ^ (h >> 29) ^ (std::uint64_t(k.policy) * 0xBF58476D1CE4E5B9ull));
+            }
+        };
+        
+        struct entry {
+            key k;
+            path_ptr path;
+            std::uint64_t serial;
+        };
+        
+        // Identifies the position of a node within a cached path.
+        struct occurrence {
+            std::uint64_t serial;
+            std::uint32_t position;
+        };
+        
+        
+        std::size_t capacity, stored_nodes = 0;
+        std::uint64_t version = 0, next_serial = 0;
+        
+        // Most recently used first.
+        std::list<entry> lru;
+        std::unordered_map<key, std::list<entry>::iterator, key_hash> entries;
+        std::unordered_map<std::uint64_t, std::list<entry>::iterator> by_serial;
+        
+        // For every node, the cached paths it lies on.
+        std::unordered_map<std::uint32_t, std::vector<occurrence>> occurrences;
+        
+        statistics stats;
+        mutable std::mutex mutex;
+        
+        
+        void validate(const graph& g) {
+            if (g.version == version) return;
+            
+            if (!entries.empty()) ++stats.invalidations;
+            
+            clear_locked();
+            version = g.version;
+        }
+        
+        
+        void clear_locked(void) {
+            lru.clear();
+            entries.clear();
+            by_serial.clear();
+            occurrences.clear();
+            stored_nodes = 0;
+        }
+        
+        
+        path_ptr insert_locked(const node* from, const node* to, std::uint32_t policy, std::vector<node*> path) {
+            const key k { std::uint32_t(from->id), std::uint32_t(to->id), policy };
+            auto result = std::make_shared<const std::vector<node*>>(std::move(path));
+            
+            if (auto it = entries.find(k); it != entries.end()) erase(it->second);
+            
+            // Paths that don't fit at all are returned without being stored.
+            if (result->size() > capacity) return result;
+            
+            while (stored_nodes + result->size() > capacity && !lru.empty()) erase(std::prev(lru.end()));
+            
+            
+            const std::uint64_t serial = next_serial++;
+            lru.push_front(entry { k, result, serial });
+            
+            entries.emplace(k, lru.begin());
+            by_serial.emplace(serial, lru.begin());
+            stored_nodes += result->size();
+            
+            for (std::uint32_t i = 0; i < result->size(); ++i) {
+                occurrences[std::uint32_t((*result)[i]->id)].push_back(occurrence { serial, i });
+            }
+            
+            return result;
+        }
+        
+        
+        void erase(std::list<entry>::iterator it) {
+            const auto& path = *it->path;
+            
+            for (const node* n : path) {
+                auto o = occurrences.find(std::uint32_t(n->id));
+                std::erase_if(o->second, [&](const occurrence& x) { return x.serial == it->serial; });
+                
+                if (o->second.empty()) occurrences.erase(o);
+            }
+            
+            stored_nodes -= path.size();
+            entries.erase(it->k);
+            by_serial.erase(it->serial);
+            lru.erase(it);
+        }
+        
+        
+        // Looks for a cached path with the same policy that passes through both from and to.
+        std::optional<std::vector<node*>> find_subpath(const node* from, const node* to, std::uint32_t policy) {
+            auto a = occurrences.find(std::uint32_t(from->id));
+            auto b = occurrences.find(std::uint32_t(to->id));
+            if (a == occurrences.end() || b == occurrences.end()) return std::nullopt;
+            
+            
+            // Both lists are in insertion order, i.e. sorted by serial, so they can be intersected in a single pass.
+            const auto& as = a->second;
+            const auto& bs = b->second;
+            
+            for (std::size_t i = 0, j = 0; i < as.size() && j < bs.size(); ) {
+                if (as[i].serial < bs[j].serial) { ++i; continue; }
+                if (bs[j].serial < as[i].serial) { ++j; continue; }
+                
+                
+                auto it = by_serial.find(as[i].serial)->second;
+                
+                if (it->k.policy == policy) {
+                    const auto& path = *it->path;
+                    const std::uint32_t begin = as[i].position, end = bs[j].position;
+                    
+                    lru.splice(lru.begin(), lru, it);
+                    
+                    if (begin <= end) return std::vector<node*>(path.begin() + begin, path.begin() + end + 1);
+                    else return std::vector<node*>(path.rend() - begin - 1, path.rend() - end);
+                }
+                
+                ++i;
+                ++j;
+            }
+            
+            return std::nullopt;
+        }
+    };
+}
\ No newline at end of file
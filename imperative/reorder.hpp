@@ -0,0 +1,188 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/common.hpp>
+
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+#include <bit>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Strategies for reorder_nodes.
+    enum class node_order {
+        // Sorted along a Hilbert curve through the positions of the nodes, so nodes that are close in space are close in memory.
+        hilbert,
+        // Breadth-first order starting from the first node of every connected component, so neighbours get nearby IDs.
+        bfs,
+        // Cuthill-McKee: breadth-first order starting from a node of minimum degree, visiting neighbours in order of increasing degree.
+        // Minimizes the largest difference between the IDs of neighbours better than plain BFS.
+        cuthill_mckee,
+        // Sorted by decreasing degree, so the most connected nodes are packed together at the front.
+        degree
+    };
+    
+    
+    // Changes the order of g.nodes so the node with ID i gets ID new_ids[i]. new_ids must be a permutation of the node IDs.
+    // The nodes themselves are not moved, so node pointers remain valid, but anything keyed by node ID must be rebuilt
+    // (e.g. landmark tables and contraction hierarchies) or remapped through new_ids.
+    // If new_ids is not a permutation, std::invalid_argument is thrown and g is left unchanged.
+    inline void permute_nodes(graph& g, const std::vector<std::size_t>& new_ids) {
+        if (new_ids.size() != g.nodes.size()) throw std::invalid_argument { "permute_nodes: new_ids must contain an ID for every node." };
+        
+        // Checked before any node is moved, so g is never left half permuted.
+        std::vector<bool> seen(new_ids.size(), false);
+        
+        for (std::size_t id : new_ids) {
+            if (id >= seen.size() || seen[id]) throw std::invalid_argument { "permute_nodes: new_ids is not a permutation." };
+            seen[id] = true;
+        }
+        
+        
+        std::vector<std::unique_ptr<node>> nodes(g.nodes.size());
+        
+        for (std::size_t i = 0; i < g.nodes.size(); ++i) {
+            nodes[new_ids[i]] = std::move(g.nodes[i]);
+            nodes[new_ids[i]]->id = new_ids[i];
+        }
+        
+        g.nodes = std::move(nodes);
+        ++g.version;
+    }
+    
+    
+    namespace detail {
+        // Distance of (x, y) along a Hilbert curve filling a square grid with sides of 2^bits.
+        inline std::uint64_t hilbert_index(std::uint64_t x, std::uint64_t y, unsigned bits) {
+            const std::uint64_t n = std::uint64_t(1) << bits;
+            std::uint64_t result = 0;
+            
+            for (std::uint64_t s = n / 2; s > 0; s /= 2) {
+                const std::uint64_t rx = (x & s) ? 1 : 0, ry = (y & s) ? 1 : 0;
+                result += s * s * ((3 * rx) ^ ry);
+                
+                // Rotate the quadrant, so the curve inside it has the right orientation.
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = n - 1 - x;
+                        y = n - 1 - y;
+                    }
+                    
+                    std::swap(x, y);
+                }
+            }
+            
+            return result;
+        }
+        
+        
+        // Returns the IDs of the nodes of g in the given order.
+        inline std::vector<std::size_t> sequence_nodes(const graph& g, node_order order) {
+            const std::size_t count = g.nodes.size();
+            
+            std::vector<std::size_t> sequence(count);
+            std::iota(sequence.begin(), sequence.end(), std::size_t(0));
+            
+            if (count == 0) return sequence;
+            
+            
+            switch (order) {
+                case node_order::hilbert: {
+                    int min_x = std::numeric_limits<int>::max(), min_y = std::numeric_limits<int>::max();
+                    int max_x = std::numeric_limits<int>::min(), max_y = std::numeric_limits<int>::min();
+                    
+                    for (const auto& n : g.nodes) {
+                        min_x = std::min(min_x, n->position.x);
+                        min_y = std::min(min_y, n->position.y);
+                        max_x = std::max(max_x, n->position.x);
+                        max_y = std::max(max_y, n->position.y);
+                    }
+                    
+                    const std::uint64_t range = std::max(std::int64_t(max_x) - min_x, std::int64_t(max_y) - min_y);
+                    const unsigned bits = std::max(1u, unsigned(std::bit_width(range)));
+                    
+                    std::vector<std::uint64_t> keys(count);
+                    for (const auto& n : g.nodes) {
+                        keys[n->id] = hilbert_index(std::uint64_t(std::int64_t(n->position.x) - min_x), std::uint64_t(std::int64_t(n->position.y) - min_y), bits);
+                    }
+                    
+                    std::stable_sort(sequence.begin(), sequence.end(), [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+                    return sequence;
+                }
+                
+                case node_order::degree: {
+                    std::stable_sort(sequence.begin(), sequence.end(), [&](std::size_t a, std::size_t b) {
+                        return g.nodes[a]->neighbours.size() > g.nodes[b]->neighbours.size();
+                    });
+                    
+                    return sequence;
+                }
+                
+                case node_order::bfs:
+                case node_order::cuthill_mckee: {
+                    const bool by_degree = (order == node_order::cuthill_mckee);
+                    const auto degree_less = [&](std::size_t a, std::size_t b) { return g.nodes[a]->neighbours.size() < g.nodes[b]->neighbours.size(); };
+                    
+                    // Every connected component is started from the first node in this order that hasn't been visited yet.
+                    std::vector<std::size_t> starts = sequence;
+                    if (by_degree) std::stable_sort(starts.begin(), starts.end(), degree_less);
+                    
+                    
+                    std::vector<bool> visited(count, false);
+                    std::vector<std::size_t> neighbours;
+                    
+                    sequence.clear();
+                    
+                    for (std::size_t start : starts) {
+                        if (visited[start]) continue;
+                        
+                        // The sequence doubles as the queue: the nodes after head have been visited but not expanded.
+                        visited[start] = true;
+                        sequence.push_back(start);
+                        
+                        for (std::size_t head = sequence.size() - 1; head < sequence.size(); ++head) {
+                            neighbours.clear();
+                            
+                            for (const node* neighbour : g.nodes[sequence[head]]->neighbours) {
+                                if (visited[neighbour->id]) continue;
+                                
+                                visited[neighbour->id] = true;
+                                neighbours.push_back(neighbour->id);
+                            }
+                            
+                            if (by_degree) std::stable_sort(neighbours.begin(), neighbours.end(), degree_less);
+                            sequence.insert(sequence.end(), neighbours.begin(), neighbours.end());
+                        }
+                    }
+                    
+                    return sequence;
+                }
+            }
+            
+            return sequence;
+        }
+    }
+    
+    
+    // Renumbers the nodes of g in the given order, to improve the cache locality of searches: nodes that are expanded together
+    // get nearby IDs, so the per-node arrays indexed by ID (the search workspace, the open set, and a csr_graph created from g afterwards)
+    // are accessed close together.
+    //
+    // Returns the permutation that was applied, where the node that had ID i now has ID result[i].
+    // See permute_nodes for what remains valid afterwards.
+    inline std::vector<std::size_t> reorder_nodes(graph& g, node_order order) {
+        const auto sequence = detail::sequence_nodes(g, order);
+        
+        std::vector<std::size_t> new_ids(sequence.size());
+        for (std::size_t i = 0; i < sequence.size(); ++i) new_ids[sequence[i]] = i;
+        
+        permute_nodes(g, new_ids);
+        return new_ids;
+    }
+}
\ No newline at end of file
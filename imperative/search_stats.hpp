@@ -0,0 +1,219 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <algorithm>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Phases of a search, which are timed separately by search_stats.
+    enum class search_phase : std::size_t { setup, search, reconstruct };
+    constexpr std::size_t search_phase_count = 3;
+    
+    constexpr const char* search_phase_names[search_phase_count] = { "setup", "search", "reconstruct" };
+    
+    
+    // Searches that accept a stats object call the following hooks on it as they run:
+    // - begin_query(), end_query(found):       around every query.
+    // - begin_phase(phase), end_phase(phase):  around every phase of a query.
+    // - expanded(node, open_size):             a node was popped from the open set, which now has open_size nodes.
+    // - relaxed():                             an edge of an expanded node was examined.
+    // - decreased_key():                       a node that was already reached got a lower gscore.
+    // - pushed(open_size):                     a node was pushed to or updated in the open set, which now has open_size nodes.
+    // - heuristic_evaluated():                 the heuristic was invoked.
+    // - allocated(bytes):                      the search allocated memory for its workspace (including the open set) or its result.
+    template <typename S> concept SearchStats = requires (S& s, search_phase p, std::size_t n) {
+        s.begin_query();
+        s.end_query(true);
+        s.begin_phase(p);
+        s.end_phase(p);
+        s.expanded(n, n);
+        s.relaxed();
+        s.decreased_key();
+        s.pushed(n);
+        s.heuristic_evaluated();
+        s.allocated(n);
+    };
+    
+    
+    // Stats object with empty hooks. Every call to it is inlined away, so a search using it compiles to the same code as one without stats.
+    struct null_stats {
+        void begin_query(void) {}
+        void end_query(bool found) {}
+        void begin_phase(search_phase phase) {}
+        void end_phase(search_phase phase) {}
+        void expanded(std::size_t node, std::size_t open_size) {}
+        void relaxed(void) {}
+        void decreased_key(void) {}
+        void pushed(std::size_t open_size) {}
+        void heuristic_evaluated(void) {}
+        void allocated(std::size_t bytes) {}
+    };
+    
+    
+    struct search_counters {
+        std::uint64_t queries = 0;
+        std::uint64_t found = 0;
+        
+        std::uint64_t expanded = 0;
+        std::uint64_t relaxed = 0;
+        std::uint64_t decreased_keys = 0;
+        std::uint64_t pushed = 0;
+        std::uint64_t heuristic_evaluations = 0;
+        std::uint64_t bytes_allocated = 0;
+        
+        // The largest number of nodes in the open set at once. For aggregated counters, this is the largest over every query.
+        std::uint64_t open_peak = 0;
+        
+        std::array<std::chrono::nanoseconds, search_phase_count> phase_time {};
+        
+        
+        search_counters& operator+=(const search_counters& other) {
+            queries               += other.queries;
+            found                 += other.found;
+            expanded              += other.expanded;
+            relaxed               += other.relaxed;
+            decreased_keys        += other.decreased_keys;
+            pushed                += other.pushed;
+            heuristic_evaluations += other.heuristic_evaluations;
+            bytes_allocated       += other.bytes_allocated;
+            open_peak              = std::max(open_peak, other.open_peak);
+            
+            for (std::size_t i = 0; i < search_phase_count; ++i) phase_time[i] += other.phase_time[i];
+            return *this;
+        }
+    };
+    
+    
+    // Collects counters for every query, and adds them to a running total when the query ends.
+    // Optionally records a timeline of the phases and expansions of every query, which can be exported as a Chrome trace
+    // (the trace event format read by chrome://tracing and Perfetto).
+    //
+    // Timing every phase reads the clock a few times per query, and tracing adds an event per expansion,
+    // so a search using this is slower than one using null_stats. A stats object must not be shared between threads
+    // that are searching at the same time, but the counters of several objects can be combined with operator+=.
+    class search_stats {
+    public:
+        // At most max_trace_events events are recorded, after which tracing stops. By default nothing is traced.
+        explicit search_stats(std::size_t max_trace_events = 0) : max_trace_events(max_trace_events) {}
+        
+        
+        void begin_query(void) {
+            query = search_counters { .queries = 1 };
+        }
+        
+        
+        void end_query(bool found) {
+            query.found = found ? 1 : 0;
+            totals += query;
+        }
+        
+        
+        void begin_phase(search_phase phase) {
+            phase_start = clock::now();
+        }
+        
+        
+        void end_phase(search_phase phase) {
+            const auto now = clock::now();
+            query.phase_time[std::size_t(phase)] += now - phase_start;
+            
+            trace(trace_event { .kind = trace_event::phase_slice, .phase = phase, .time = phase_start, .end = now });
+        }
+        
+        
+        void expanded(std::size_t node, std::size_t open_size) {
+            ++query.expanded;
+            trace(trace_event { .kind = trace_event::expansion_sample, .time = clock::now(), .expanded = query.expanded, .open_size = open_size });
+        }
+        
+        
+        void relaxed(void) { ++query.relaxed; }
+        void decreased_key(void) { ++query.decreased_keys; }
+        void heuristic_evaluated(void) { ++query.heuristic_evaluations; }
+        void allocated(std::size_t bytes) { query.bytes_allocated += bytes; }
+        
+        
+        void pushed(std::size_t open_size) {
+            ++query.pushed;
+            query.open_peak = std::max<std::uint64_t>(query.open_peak, open_size);
+        }
+        
+        
+        // Counters of the last query, or of the current one while it is running.
+        const search_counters& last_query(void) const { return query; }
+        
+        // Counters of every finished query since construction or the last call to reset.
+        const search_counters& total(void) const { return totals; }
+        
+        
+        void reset(void) {
+            query  = search_counters {};
+            totals = search_counters {};
+            events.clear();
+        }
+        
+        
+        // Writes the recorded events as a Chrome trace. Every query is shown as a separate thread, with its phases as slices
+        // and the number of expanded nodes and the size of the open set as counters.
+        void write_chrome_trace(std::ostream& stream) const {
+            const auto microseconds = [&](clock::time_point t) { return std::chrono::duration<double, std::micro>(t - epoch).count(); };
+            
+            const auto flags = stream.flags();
+            const auto precision = stream.precision();
+            
+            stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+            
+            for (std::size_t i = 0; i < events.size(); ++i) {
+                const auto& e = events[i];
+                stream << (i == 0 ? "\n" : ",\n");
+                
+                if (e.kind == trace_event::phase_slice) {
+                    stream << "{\"name\":\"" << search_phase_names[std::size_t(e.phase)] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.query
+                           << ",\"ts\":" << microseconds(e.time) << ",\"dur\":" << std::chrono::duration<double, std::micro>(e.end - e.time).count() << "}";
+                } else {
+                    stream << "{\"name\":\"query " << e.query << "\",\"ph\":\"C\",\"pid\":1,\"tid\":" << e.query
+                           << ",\"ts\":" << microseconds(e.time) << ",\"args\":{\"expanded\":" << e.expanded << ",\"open\":" << e.open_size << "}}";
+                }
+            }
+            
+            stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            
+            stream.flags(flags);
+            stream.precision(precision);
+        }
+    private:
+        using clock = std::chrono::steady_clock;
+        
+        
+        struct trace_event {
+            enum { phase_slice, expansion_sample } kind;
+            search_phase phase = search_phase::setup;
+            std::uint64_t query = 0;
+            clock::time_point time {}, end {};
+            std::uint64_t expanded = 0, open_size = 0;
+        };
+        
+        
+        search_counters query, totals;
+        clock::time_point phase_start;
+        
+        std::vector<trace_event> events;
+        std::size_t max_trace_events;
+        clock::time_point epoch = clock::now();
+        
+        
+        void trace(trace_event e) {
+            if (events.size() >= max_trace_events) return;
+            
+            e.query = totals.queries;
+            events.push_back(e);
+        }
+    };
+}
\ No newline at end of file
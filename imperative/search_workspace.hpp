@@ -0,0 +1,88 @@
+#pragma once
+
+#include <imperative/open_set.hpp>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Per-query search state (gscores, parents and the open set), stored in dense arrays indexed by node ID.
+    // A workspace can be reused between queries: each entry is stamped with the generation of the query that last
+    // wrote it, so starting a new query only increments the generation instead of resetting every node.
+    // A workspace must not be shared between threads that are searching at the same time.
+    template <typename OpenSet = heap_open_set>
+    class basic_search_workspace {
+    public:
+        constexpr static std::uint32_t no_parent = std::numeric_limits<std::uint32_t>::max();
+        
+        
+        // Prepares the workspace for a new search over a graph with the given number of nodes.
+        void begin_query(std::size_t nodes) {
+            if (records.size() < nodes) records.resize(nodes);
+            
+            if (++generation == 0) {
+                // The generation counter wrapped around, so old stamps could appear valid again.
+                for (auto& r : records) r.generation = 0;
+                generation = 1;
+            }
+            
+            open.reset(nodes);
+        }
+        
+        
+        bool visited(std::size_t n) const {
+            return records[n].generation == generation;
+        }
+        
+        float gscore(std::size_t n) const {
+            return visited(n) ? records[n].gscore : std::numeric_limits<float>::infinity();
+        }
+        
+        std::uint32_t came_from(std::size_t n) const {
+            return visited(n) ? records[n].came_from : no_parent;
+        }
+        
+        
+        void visit(std::size_t n, float gscore, std::uint32_t came_from) {
+            records[n] = record { generation, gscore, came_from };
+        }
+        
+        
+        // Returns the path from the start of the search to n, as a list of node IDs.
+        std::vector<std::uint32_t> path_to(std::size_t n) const {
+            std::vector<std::uint32_t> result { std::uint32_t(n) };
+            
+            for (std::uint32_t prev = came_from(n); prev != no_parent; prev = came_from(prev)) {
+                result.push_back(prev);
+            }
+            
+            std::reverse(result.begin(), result.end());
+            return result;
+        }
+        
+        
+        // Approximate memory used by the per-node records and the open set in bytes.
+        std::size_t memory_usage(void) const {
+            return records.capacity() * sizeof(record) + open.memory_usage();
+        }
+        
+        
+        OpenSet open;
+    private:
+        struct record {
+            std::uint32_t generation = 0;
+            float gscore;
+            std::uint32_t came_from;
+        };
+        
+        std::vector<record> records;
+        std::uint32_t generation = 0;
+    };
+    
+    
+    using search_workspace = basic_search_workspace<heap_open_set>;
+}
\ No newline at end of file
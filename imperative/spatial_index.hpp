@@ -0,0 +1,349 @@
+#pragma once
+
+#include <imperative/graph.hpp>
+#include <imperative/common.hpp>
+#include <imperative/csr_graph.hpp>
+#include <imperative/thread_pool.hpp>
+#include <imperative/reorder.hpp>
+
+#include <vector>
+#include <span>
+#include <queue>
+#include <utility>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace imp {
+    // Static k-d tree over the positions of the nodes of a graph, to find the nodes closest to a given position in O(log V)
+    // rather than scanning every node. The tree is implicit: the points are stored in a single array, where the median of every range
+    // splits it into the two halves, so the only overhead per node is the point itself and the dimension its range was split on.
+    // Ranges of at most leaf_size points are not split further and are scanned linearly.
+    //
+    // Distances are euclidean. Ties are broken by node ID, so results don't depend on the shape of the tree.
+    // The index is a snapshot: it must be rebuilt when nodes are added or moved, or when node IDs change (see reorder_nodes).
+    class spatial_index {
+    public:
+        using id_type = std::uint32_t;
+        constexpr static id_type invalid_id = std::numeric_limits<id_type>::max();
+        
+        constexpr static std::size_t leaf_size = 8;
+        
+        
+        spatial_index(void) = default;
+        
+        
+        static spatial_index build(const graph& g) {
+            return from_positions(g.nodes.size(), [&](std::size_t i) { return g.nodes[i]->position; }, nullptr);
+        }
+        
+        // As above, but the subtrees below the first few levels are built in parallel by the workers of pool.
+        static spatial_index build(const graph& g, thread_pool& pool) {
+            return from_positions(g.nodes.size(), [&](std::size_t i) { return g.nodes[i]->position; }, &pool);
+        }
+        
+        
+        template <CsrGraph G> static spatial_index build(const G& g) {
+            return from_positions(g.node_count(), [&](std::size_t i) { return g.position(id_type(i)); }, nullptr);
+        }
+        
+        template <CsrGraph G> static spatial_index build(const G& g, thread_pool& pool) {
+            return from_positions(g.node_count(), [&](std::size_t i) { return g.position(id_type(i)); }, &pool);
+        }
+        
+        
+        std::size_t size(void) const { return points.size(); }
+        
+        
+        // Returns the node closest to position, or invalid_id if the index is empty.
+        id_type nearest(vec2i position) const {
+            candidate best { std::numeric_limits<std::int64_t>::max(), invalid_id };
+            find_nearest(position, best);
+            
+            return best.id;
+        }
+        
+        
+        // Returns the node closest to every position in positions. The positions are visited along a Hilbert curve,
+        // and the result of the previous position bounds the search for the next one, so nearby positions share most of their traversal.
+        std::vector<id_type> nearest(std::span<const vec2i> positions) const {
+            std::vector<id_type> result(positions.size());
+            find_nearest_batch(positions, spatial_order(positions), 0, positions.size(), result);
+            
+            return result;
+        }
+        
+        
+        // As above, with consecutive runs of the ordered positions divided between the workers of pool.
+        std::vector<id_type> nearest(std::span<const vec2i> positions, thread_pool& pool) const {
+            std::vector<id_type> result(positions.size());
+            const auto order = spatial_order(positions);
+            
+            pool.parallel_for(positions.size(), 4096, [&](std::size_t begin, std::size_t end, unsigned worker) {
+                find_nearest_batch(positions, order, begin, end, result);
+            });
+            
+            return result;
+        }
+        
+        
+        // Returns the k nodes closest to position, closest first. Returns fewer nodes if the index contains less than k.
+        std::vector<id_type> k_nearest(vec2i position, std::size_t k) const {
+            std::priority_queue<candidate> best;
+            if (k > 0) find_k_nearest(position, k, best);
+            
+            std::vector<id_type> result(best.size());
+            for (std::size_t i = result.size(); i > 0; --i, best.pop()) result[i - 1] = best.top().id;
+            
+            return result;
+        }
+        
+        
+        // Returns every node at most radius away from position, closest first.
+        std::vector<id_type> within_radius(vec2i position, float radius) const {
+            if (radius < 0) return {};
+            
+            std::vector<candidate> found;
+            find_within(position, std::int64_t(double(radius) * double(radius)), found);
+            
+            std::sort(found.begin(), found.end());
+            
+            std::vector<id_type> result;
+            result.reserve(found.size());
+            for (const auto& c : found) result.push_back(c.id);
+            
+            return result;
+        }
+        
+        
+        // Approximate memory used by the index in bytes.
+        std::size_t memory_usage(void) const {
+            return points.capacity() * sizeof(point) + split_dimensions.capacity() * sizeof(std::uint8_t);
+        }
+    private:
+        struct point {
+            int x, y;
+            id_type id;
+            
+            std::int64_t coordinate(std::uint8_t dimension) const { return dimension == 0 ? x : y; }
+        };
+        
+        
+        struct candidate {
+            std::int64_t squared_distance;
+            id_type id;
+            
+            bool operator<(const candidate& other) const {
+                return std::pair { squared_distance, id } < std::pair { other.squared_distance, other.id };
+            }
+        };
+        
+        
+        std::vector<point> points;
+        // For every range that was split, the dimension it was split on (0 for x, 1 for y), stored at the index of its median.
+        std::vector<std::uint8_t> split_dimensions;
+        
+        
+        static std::int64_t squared_distance(const point& p, vec2i position) {
+            const std::int64_t dx = std::int64_t(p.x) - position.x, dy = std::int64_t(p.y) - position.y;
+            return dx * dx + dy * dy;
+        }
+        
+        
+        static std::int64_t coordinate(vec2i position, std::uint8_t dimension) {
+            return dimension == 0 ? position.x : position.y;
+        }
+        
+        
+        static spatial_index from_positions(std::size_t count, auto&& position_of, thread_pool* pool) {
+            if (count >= invalid_id) throw std::invalid_argument { "spatial_index: the graph has too many nodes." };
+            
+            spatial_index result;
+            result.points.resize(count);
+            result.split_dimensions.resize(count);
+            
+            for (std::size_t i = 0; i < count; ++i) {
+                const vec2i p = position_of(i);
+                result.points[i] = point { p.x, p.y, id_type(i) };
+            }
+            
+            
+            if (!pool) {
+                result.build_range(0, count);
+                return result;
+            }
+            
+            
+            // Split the top levels on this thread until there are enough independent subtrees to keep every worker busy.
+            std::vector<std::pair<std::size_t, std::size_t>> ranges { { 0, count } }, next;
+            
+            while (ranges.size() < 4 * pool->size()) {
+                next.clear();
+                
+                for (auto [begin, end] : ranges) {
+                    if (end - begin <= leaf_size) continue;
+                    
+                    const std::size_t median = result.split_range(begin, end);
+                    next.emplace_back(begin, median);
+                    next.emplace_back(median + 1, end);
+                }
+                
+                if (next.empty()) return result;
+                std::swap(ranges, next);
+            }
+            
+            pool->parallel_for(ranges.size(), 1, [&](std::size_t begin, std::size_t end, unsigned worker) {
+                for (std::size_t i = begin; i < end; ++i) result.build_range(ranges[i].first, ranges[i].second);
+            });
+            
+            return result;
+        }
+        
+        
+        // Splits [begin, end) on the dimension in which it is widest, and returns the index of the median.
+        std::size_t split_range(std::size_t begin, std::size_t end) {
+            int min_x = std::numeric_limits<int>::max(), min_y = std::numeric_limits<int>::max();
+            int max_x = std::numeric_limits<int>::min(), max_y = std::numeric_limits<int>::min();
+            
+            for (std::size_t i = begin; i < end; ++i) {
+                min_x = std::min(min_x, points[i].x);
+                min_y = std::min(min_y, points[i].y);
+                max_x = std::max(max_x, points[i].x);
+                max_y = std::max(max_y, points[i].y);
+            }
+            
+            const std::uint8_t dimension = (std::int64_t(max_x) - min_x >= std::int64_t(max_y) - min_y) ? 0 : 1;
+            const std::size_t median = begin + (end - begin) / 2;
+            
+            std::nth_element(points.begin() + std::ptrdiff_t(begin), points.begin() + std::ptrdiff_t(median), points.begin() + std::ptrdiff_t(end), [&](const point& a, const point& b) {
+                return a.coordinate(dimension) < b.coordinate(dimension);
+            });
+            
+            split_dimensions[median] = dimension;
+            return median;
+        }
+        
+        
+        void build_range(std::size_t begin, std::size_t end) {
+            if (end - begin <= leaf_size) return;
+            
+            const std::size_t median = split_range(begin, end);
+            build_range(begin, median);
+            build_range(median + 1, end);
+        }
+        
+        
+        // Visits [begin, end), invoking leaf(p) for every point that might be in range, where bound() is the squared distance
+        // beyond which points are no longer of interest. The half of every range on the same side as position is visited first.
+        template <typename Leaf, typename Bound>
+        void visit(std::size_t begin, std::size_t end, vec2i position, Leaf& leaf, Bound& bound) const {
+            if (end - begin <= leaf_size) {
+                for (std::size_t i = begin; i < end; ++i) leaf(points[i]);
+                return;
+            }
+            
+            
+            const std::size_t median = begin + (end - begin) / 2;
+            const std::uint8_t dimension = split_dimensions[median];
+            const std::int64_t difference = coordinate(position, dimension) - points[median].coordinate(dimension);
+            
+            leaf(points[median]);
+            
+            if (difference < 0) {
+                visit(begin, median, position, leaf, bound);
+                if (difference * difference <= bound()) visit(median + 1, end, position, leaf, bound);
+            } else {
+                visit(median + 1, end, position, leaf, bound);
+                if (difference * difference <= bound()) visit(begin, median, position, leaf, bound);
+            }
+        }
+        
+        
+        // Updates best if there is a closer node, and returns the point of that node, or nullptr if there is none.
+        const point* find_nearest(vec2i position, candidate& best) const {
+            const point* result = nullptr;
+            
+            auto leaf = [&](const point& p) {
+                const candidate c { squared_distance(p, position), p.id };
+                
+                if (c < best) {
+                    best = c;
+                    result = &p;
+                }
+            };
+            
+            auto bound = [&] { return best.squared_distance; };
+            
+            visit(0, points.size(), position, leaf, bound);
+            return result;
+        }
+        
+        
+        void find_k_nearest(vec2i position, std::size_t k, std::priority_queue<candidate>& best) const {
+            auto leaf = [&](const point& p) {
+                const candidate c { squared_distance(p, position), p.id };
+                
+                if (best.size() < k) {
+                    best.push(c);
+                } else if (c < best.top()) {
+                    best.pop();
+                    best.push(c);
+                }
+            };
+            
+            auto bound = [&] { return best.size() < k ? std::numeric_limits<std::int64_t>::max() : best.top().squared_distance; };
+            
+            visit(0, points.size(), position, leaf, bound);
+        }
+        
+        
+        void find_within(vec2i position, std::int64_t squared_radius, std::vector<candidate>& found) const {
+            auto leaf = [&](const point& p) {
+                const std::int64_t d = squared_distance(p, position);
+                if (d <= squared_radius) found.push_back(candidate { d, p.id });
+            };
+            
+            auto bound = [&] { return squared_radius; };
+            
+            visit(0, points.size(), position, leaf, bound);
+        }
+        
+        
+        // Returns the indices of positions, sorted along a Hilbert curve.
+        static std::vector<std::size_t> spatial_order(std::span<const vec2i> positions) {
+            std::vector<std::size_t> order(positions.size());
+            std::iota(order.begin(), order.end(), std::size_t(0));
+            
+            std::vector<std::uint64_t> keys(positions.size());
+            for (std::size_t i = 0; i < positions.size(); ++i) {
+                // Offsetting by 2^31 maps every int to a distinct unsigned 32 bit value while preserving order.
+                keys[i] = detail::hilbert_index(std::uint64_t(std::int64_t(positions[i].x) + (std::int64_t(1) << 31)), std::uint64_t(std::int64_t(positions[i].y) + (std::int64_t(1) << 31)), 32);
+            }
+            
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+            return order;
+        }
+        
+        
+        // Finds the nearest nodes of positions[order[begin]] to positions[order[end - 1]].
+        void find_nearest_batch(std::span<const vec2i> positions, const std::vector<std::size_t>& order, std::size_t begin, std::size_t end, std::vector<id_type>& result) const {
+            const point* previous = nullptr;
+            
+            for (std::size_t i = begin; i < end; ++i) {
+                const vec2i position = positions[order[i]];
+                
+                // The previous result is an upper bound on the distance to the nearest node, so most of the tree is pruned straight away.
+                candidate best { std::numeric_limits<std::int64_t>::max(), invalid_id };
+                if (previous) best = candidate { squared_distance(*previous, position), previous->id };
+                
+                if (const point* closest = find_nearest(position, best)) previous = closest;
+                
+                result[order[i]] = best.id;
+            }
+        }
+    };
+}
\ No newline at end of file
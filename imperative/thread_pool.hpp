@@ -0,0 +1,172 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <latch>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+
+namespace imp {
+    // Fixed-size thread pool with a work-stealing scheduler.
+    // Every worker owns a task queue: it takes tasks from the back of its own queue,
+    // and when that is empty it steals from the front of the queues of the other workers.
+    // Tasks are invoked with the index of the worker running them, which can be used to index per-worker state.
+    class thread_pool {
+    public:
+        using task = std::function<void(unsigned worker)>;
+        
+        
+        explicit thread_pool(unsigned threads = std::thread::hardware_concurrency()) : queues(std::max(threads, 1u)) {
+            for (auto& q : queues) q = std::make_unique<queue>();
+            
+            for (unsigned i = 0; i < queues.size(); ++i) {
+                workers.emplace_back([this, i](std::stop_token stop) { work(i, stop); });
+            }
+        }
+        
+        
+        ~thread_pool(void) {
+            for (auto& w : workers) w.request_stop();
+            
+            { std::lock_guard lock { sleep_mutex }; }
+            wake.notify_all();
+        }
+        
+        
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        
+        
+        unsigned size(void) const {
+            return unsigned(queues.size());
+        }
+        
+        
+        // Queues a task on the given worker. Other workers will steal it if that worker is busy.
+        void submit(task t, unsigned worker) {
+            // The count is incremented first, so it never drops below zero when the task is taken straight away.
+            {
+                std::lock_guard lock { sleep_mutex };
+                ++queued;
+            }
+            
+            {
+                auto& q = *queues[worker % queues.size()];
+                
+                std::lock_guard lock { q.mutex };
+                q.tasks.push_back(std::move(t));
+            }
+            
+            wake.notify_one();
+        }
+        
+        
+        // Invokes fn(begin, end, worker) for consecutive ranges of at most chunk elements covering [0, count),
+        // and blocks until all of them have finished. If any invocation throws, the first exception is rethrown here.
+        // Must not be called from within a task of the same pool.
+        template <typename F>
+        void parallel_for(std::size_t count, std::size_t chunk, F&& fn) {
+            chunk = std::max<std::size_t>(chunk, 1);
+            const std::size_t chunks = (count + chunk - 1) / chunk;
+            if (chunks == 0) return;
+            
+            std::latch done { std::ptrdiff_t(chunks) };
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            
+            
+            // Chunks are dealt out round-robin, so every worker starts with a contiguous share of the work.
+            for (std::size_t i = 0; i < chunks; ++i) {
+                const std::size_t begin = i * chunk, end = std::min(begin + chunk, count);
+                
+                submit([&, begin, end](unsigned worker) {
+                    try {
+                        fn(begin, end, worker);
+                    } catch (...) {
+                        std::lock_guard lock { error_mutex };
+                        if (!error) error = std::current_exception();
+                    }
+                    
+                    done.count_down();
+                }, unsigned(i % queues.size()));
+            }
+            
+            
+            done.wait();
+            if (error) std::rethrow_exception(error);
+        }
+    private:
+        struct queue {
+            std::mutex mutex;
+            std::deque<task> tasks;
+        };
+        
+        std::vector<std::unique_ptr<queue>> queues;
+        
+        std::mutex sleep_mutex;
+        std::condition_variable wake;
+        std::size_t queued = 0;
+        
+        // Declared last, so the workers are stopped and joined before anything they use is destroyed.
+        std::vector<std::jthread> workers;
+        
+        
+        bool take(unsigned worker, task& result) {
+            auto try_pop = [&](unsigned index, bool own) {
+                auto& q = *queues[index];
+                std::lock_guard lock { q.mutex };
+                
+                if (q.tasks.empty()) return false;
+                
+                if (own) {
+                    result = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                } else {
+                    result = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                }
+                
+                return true;
+            };
+            
+            
+            bool found = try_pop(worker, true);
+            
+            for (unsigned i = 1; !found && i < queues.size(); ++i) {
+                found = try_pop((worker + i) % queues.size(), false);
+            }
+            
+            if (found) {
+                std::lock_guard lock { sleep_mutex };
+                --queued;
+            }
+            
+            return found;
+        }
+        
+        
+        void work(unsigned worker, std::stop_token stop) {
+            task t;
+            
+            while (!stop.stop_requested()) {
+                if (take(worker, t)) {
+                    t(worker);
+                    t = nullptr;
+                    
+                    continue;
+                }
+                
+                
+                std::unique_lock lock { sleep_mutex };
+                wake.wait(lock, [&] { return queued > 0 || stop.stop_requested(); });
+            }
+        }
+    };
+}
\ No newline at end of file